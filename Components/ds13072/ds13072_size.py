@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""
+DS13072 linked size per feature.
+
+Reads the GNU ld map file of the application and sums, for every object file
+of the DS13072 component, the bytes of its input sections that were kept in
+the link. Every feature is its own object file (DS13072_<feature>.c, and
+DS13072_platform_<feature>.c for its platform part), so the result is the
+linked cost of each enabled feature. Sections removed by --gc-sections are
+not counted; an object whose sections were all removed is listed with 0, and
+an object nothing refers to is not pulled from the library at all.
+
+Run after the build by CONFIG_DS13072_SIZE_REPORT, or by hand:
+    python ds13072_size.py build/<project>.map
+"""
+
+import re
+import sys
+
+# object file of the component, in a library: lib<name>.a(DS13072_x.c.obj)
+OBJECT = re.compile(r'lib[^\s(]*\.a\((DS13072[A-Za-z0-9_]*)(?:\.c)?\.o(?:bj)?\)')
+# input section: " .text.Name  0xaddr  0xsize  object", name may be alone
+# on the line before
+SECTION = re.compile(r'^ (\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.*))?$')
+CONTINUED = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+
+COLUMNS = ('text', 'rodata', 'data', 'bss', 'iram')
+SKIP = ('.debug', '.comment', '.note', '.stab', '.xtensa.info',
+        '.riscv.attributes', '.xt.', '.gnu.attributes')
+
+
+def kind(output):
+    """Memory of an output section, by its name"""
+    if output.startswith(SKIP):
+        return None
+    if 'bss' in output or 'noinit' in output:
+        return 'bss'
+    if 'iram' in output or output.startswith('.rtc.text'):
+        return 'iram'
+    if 'rodata' in output or 'eh_frame' in output:
+        return 'rodata'
+    if 'data' in output:
+        return 'data'
+    if 'text' in output or 'literal' in output:
+        return 'text'
+    return 'rodata'
+
+
+def feature(obj):
+    """Feature of an object file: DS13072_platform_sync -> sync (platform)"""
+    name = obj[len('DS13072'):].lstrip('_')
+    if not name:
+        return 'core'
+    if name == 'platform':
+        return 'platform (I2C)'
+    if name.startswith('platform_'):
+        return name[len('platform_'):] + ' (platform)'
+    return name
+
+
+def parse(lines):
+    sizes = {}
+    output = None
+    pending = None
+    in_map = False
+
+    for line in lines:
+        line = line.rstrip('\n')
+        for obj in OBJECT.findall(line):
+            sizes.setdefault(obj, dict.fromkeys(COLUMNS, 0))
+
+        if not in_map:
+            in_map = line.startswith('Linker script and memory map')
+            continue
+
+        # output section, e.g. ".flash.text  0x42000020  0x1234"
+        if line.startswith('.'):
+            output = kind(line.split()[0])
+            pending = None
+            continue
+
+        size = obj = None
+        match = SECTION.match(line)
+        if match and not line.startswith(' *'):
+            if match.group(2) is None:
+                pending = match.group(1)
+                continue
+            size, obj = match.group(3), match.group(4)
+        elif pending:
+            match = CONTINUED.match(line)
+            if match:
+                size, obj = match.group(2), match.group(3)
+            pending = None
+
+        if size is None or output is None:
+            continue
+
+        match = OBJECT.search(obj)
+        if match:
+            sizes[match.group(1)][output] += int(size, 16)
+
+    return sizes
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write('usage: %s <map file>\n' % argv[0])
+        return 1
+
+    try:
+        with open(argv[1], errors='replace') as mapfile:
+            sizes = parse(mapfile)
+    except OSError as err:
+        # never fail the build for the report
+        print('DS13072 size report: %s' % err)
+        return 0
+
+    rows = sorted(sizes.items(),
+                  key=lambda item: (feature(item[0]) != 'core',
+                                    feature(item[0])))
+    print('%-24s %7s %7s   %7s %7s %7s %7s %7s' %
+          (('feature', 'flash', 'RAM') + COLUMNS))
+    total = dict.fromkeys(COLUMNS, 0)
+    for obj, size in rows:
+        for column in COLUMNS:
+            total[column] += size[column]
+        print_row(feature(obj), size)
+    print_row('total', total)
+    return 0
+
+
+def print_row(name, size):
+    flash = size['text'] + size['rodata'] + size['data'] + size['iram']
+    ram = size['data'] + size['bss'] + size['iram']
+    print('%-24s %7d %7d   %7d %7d %7d %7d %7d' %
+          ((name, flash, ram) + tuple(size[c] for c in COLUMNS)))
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
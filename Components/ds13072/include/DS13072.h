@@ -10,6 +10,9 @@ extern "C" {
 /* Includes ---------------------------------------------------------------------*/
 #include <stdint.h>
 #include <stdbool.h>
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
 
 /* Exported Data Types ----------------------------------------------------------*/
 
@@ -45,6 +48,13 @@ typedef int8_t (*DS13072_PlatformInitDeinit_t)(void);
 typedef int8_t (*DS13072_PlatformSendReceive_t)(uint8_t Address,
                                                 uint8_t *Data, uint8_t Len);
 
+/**
+ * @brief  Function type for taking/releasing the bus of the handler.
+ * @note   The lock is held for one register access, which can be more than
+ *         one transfer (e.g. the register pointer write and the read).
+ */
+typedef void (*DS13072_PlatformLock_t)(void);
+
 /**
  * @brief  Handler
  * @note   This handler must be initialize before using library functions
@@ -59,6 +69,10 @@ typedef struct DS13072_Handler_s
   DS13072_PlatformSendReceive_t PlatformSend;
   // Receive Data from the DS13072
   DS13072_PlatformSendReceive_t PlatformReceive;
+  // Serialize the register accesses of tasks that share the handler (e.g.
+  // the application and a background module); can be NULL
+  DS13072_PlatformLock_t PlatformLock;
+  DS13072_PlatformLock_t PlatformUnlock;
 } DS13072_Handler_t;
 
 /**
@@ -92,14 +106,124 @@ typedef enum DS13072_OutWave_e
 } DS13072_OutWave_t;
 
 
+/**
+ * @brief  Function type for reading the monotonic clock used by
+ *         DS13072_SyncToSecondEdge.
+ * @param  TimeUs: Pointer to store the time in microseconds
+ * @retval
+ *         -  0: The operation was successful.
+ *         - -1: The operation failed.
+ */
+typedef int8_t (*DS13072_SyncGetUs_t)(uint64_t *TimeUs);
+
+/**
+ * @brief  Function type for waiting a number of microseconds.
+ * @param  DelayUs: Time to wait in microseconds
+ * @retval None
+ */
+typedef void (*DS13072_SyncDelayUs_t)(uint32_t DelayUs);
+
+/**
+ * @brief  Function type for waiting for the next edge of the 1Hz SQW/OUT
+ *         signal.
+ * @param  TimeoutMs: Maximum time to wait in milliseconds
+ * @param  EdgeUs: Pointer to store the monotonic time of the edge
+ * @retval
+ *         -  0: The operation was successful.
+ *         - -1: No edge before the timeout.
+ */
+typedef int8_t (*DS13072_SyncWaitEdge_t)(uint32_t TimeoutMs, uint64_t *EdgeUs);
+
+/**
+ * @brief  Second-edge synchronization parameters
+ */
+typedef struct DS13072_Sync_s
+{
+  // Reads a monotonic clock in microseconds
+  DS13072_SyncGetUs_t GetMonotonicUs;
+  // Waits a number of microseconds
+  DS13072_SyncDelayUs_t DelayUs;
+  // Waits for the next SQW/OUT edge; NULL if SQW/OUT is not wired
+  DS13072_SyncWaitEdge_t WaitSqwEdge;
+  // Maximum number of register reads; 0: DS13072_SYNC_MAX_READS
+  uint16_t MaxReads;
+} DS13072_Sync_t;
+
+/**
+ * @brief  Second-edge synchronization result
+ */
+typedef struct DS13072_SyncResult_s
+{
+  // RTC date and time that starts at the edge (24-hour mode)
+  DS13072_DateTime_t DateTime;
+  // Monotonic time of the edge (us)
+  uint64_t EdgeUs;
+  // The edge is within EdgeUs +/- UncertaintyUs
+  uint32_t UncertaintyUs;
+  // Number of register reads used
+  uint16_t BusReads;
+} DS13072_SyncResult_t;
+
+
 /* Functionality Options --------------------------------------------------------*/
 /**
  * @brief  Specify Send buffer size.
  * @note   larger buffer size => better performance
  * @note   The DS13072_SEND_BUFFER_SIZE must be set larger than 1 (9 or more is
  *         suggested)
+ * @note   Set with CONFIG_DS13072_SEND_BUFFER_SIZE in menuconfig
  */   
+#ifdef CONFIG_DS13072_SEND_BUFFER_SIZE
+#define DS13072_SEND_BUFFER_SIZE   CONFIG_DS13072_SEND_BUFFER_SIZE
+#else
 #define DS13072_SEND_BUFFER_SIZE   9
+#endif
+
+/**
+ * @brief  Unix time limits of the range the chip can hold (2000 to 2099)
+ */
+#define DS13072_UNIX_2000  946684800U   // 2000-01-01 00:00:00
+#define DS13072_UNIX_2100  4102444800U  // 2100-01-01 00:00:00
+
+/**
+ * @brief  HOUR register bits, as decoded by DS13072_RegsToDateTime
+ */
+#define DS13072_HOUR_12H  6  // 1: 12-hour mode
+#define DS13072_HOUR_PM   5  // 1: PM, in 12-hour mode only
+
+/**
+ * @brief  Optional driver features (1: compiled in, 0: compiled out)
+ * @note   Selected in menuconfig; outside ESP-IDF all features are enabled.
+ */
+#if !defined(ESP_PLATFORM) || defined(CONFIG_DS13072_12HOUR)
+#define DS13072_USE_12HOUR   1
+#else
+#define DS13072_USE_12HOUR   0
+#endif
+
+#if !defined(ESP_PLATFORM) || defined(CONFIG_DS13072_NVRAM)
+#define DS13072_USE_NVRAM    1
+#else
+#define DS13072_USE_NVRAM    0
+#endif
+
+#if !defined(ESP_PLATFORM) || defined(CONFIG_DS13072_SQW)
+#define DS13072_USE_SQW      1
+#else
+#define DS13072_USE_SQW      0
+#endif
+
+#if !defined(ESP_PLATFORM) || defined(CONFIG_DS13072_SYNC)
+#define DS13072_USE_SYNC     1
+#else
+#define DS13072_USE_SYNC     0
+#endif
+
+/**
+ * @brief  Default register read budget of DS13072_SyncToSecondEdge.
+ * @note   The polling search usually needs about 40 reads.
+ */
+#define DS13072_SYNC_MAX_READS  64
 
 
 
@@ -141,6 +265,9 @@ DS13072_DeInit(DS13072_Handler_t *Handler);
 
 /**
  * @brief  Set date and time on DS13072 real time chip
+ * @note   In 12-hour mode (HourMode = 1) the Hour field must be 1 to 12 and
+ *         isPM selects AM/PM. HourMode = 1 is rejected when
+ *         DS13072_USE_12HOUR is 0.
  * @param  Handler: Pointer to handler
  * @param  DateTime: pointer to date and time value structure
  * @retval DS13072_Result_t
@@ -164,7 +291,74 @@ DS13072_Result_t
 DS13072_GetDateTime(DS13072_Handler_t *Handler, DS13072_DateTime_t *DateTime);
 
 
+/**
+ * @brief  Get the seconds from DS13072 real time chip
+ * @note   Reads only the SECOND register, which is enough to find the moment
+ *         it rolls over.
+ * @param  Handler: Pointer to handler
+ * @param  Second: pointer to store the seconds
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data.
+ */
+DS13072_Result_t
+DS13072_GetSecond(DS13072_Handler_t *Handler, uint8_t *Second);
 
+
+
+/**
+ ==================================================================================
+                         ##### Conversion Functions #####                          
+ ==================================================================================
+ */
+
+/**
+ * @brief  Decode the date and time registers
+ * @note   This is the decoder of DS13072_GetDateTime. In 12-hour mode (bit
+ *         DS13072_HOUR_12H of the HOUR register) the Hour field is 1 to 12 and
+ *         isPM is bit DS13072_HOUR_PM. The clock halt bit is ignored and
+ *         WeekDay is not checked.
+ * @param  Regs: 7-byte burst read from the SECOND register onwards
+ * @param  DateTime: pointer to date and time value structure
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: A BCD digit is out of range; DateTime is
+ *                                  still filled in.
+ */
+DS13072_Result_t
+DS13072_RegsToDateTime(const uint8_t Regs[7], DS13072_DateTime_t *DateTime);
+
+
+/**
+ * @brief  Convert date and time to Unix time (seconds since 1970-01-01 00:00:00)
+ * @note   The year is taken as 2000 + DateTime->Year. In 12-hour mode (HourMode
+ *         = 1) the Hour field must be 1 to 12 and isPM selects AM/PM.
+ * @note   WeekDay is not checked and does not take part in the conversion.
+ * @param  DateTime: pointer to date and time value structure
+ * @param  UnixTime: pointer to store the result
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_DateTimeToUnix(const DS13072_DateTime_t *DateTime, uint32_t *UnixTime);
+
+
+/**
+ * @brief  Convert Unix time to date and time in 24-hour mode
+ * @note   WeekDay is set from 1 (Monday) to 7 (Sunday).
+ * @param  UnixTime: seconds since 1970-01-01 00:00:00 (2000 to 2099 only)
+ * @param  DateTime: pointer to date and time value structure
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: UnixTime is outside 2000 to 2099.
+ */
+DS13072_Result_t
+DS13072_UnixToDateTime(uint32_t UnixTime, DS13072_DateTime_t *DateTime);
+
+
+
+#if DS13072_USE_NVRAM
 /**
  ==================================================================================
                            ##### Memory Functions #####                            
@@ -201,9 +395,11 @@ DS13072_WriteRAM(DS13072_Handler_t *Handler,
 DS13072_Result_t
 DS13072_ReadRAM(DS13072_Handler_t *Handler,
                uint8_t Address, uint8_t *Data, uint8_t Size);
+#endif
 
 
 
+#if DS13072_USE_SQW
 /**
  ==================================================================================
                           ##### Out Wave Functions #####                           
@@ -228,9 +424,45 @@ DS13072_ReadRAM(DS13072_Handler_t *Handler,
  */
 DS13072_Result_t
 DS13072_SetOutWave(DS13072_Handler_t *Handler, DS13072_OutWave_t OutWave);
+#endif
 
 
 
+#if DS13072_USE_SYNC
+/**
+ ==================================================================================
+                        ##### Synchronization Functions #####                      
+ ==================================================================================
+ */
+
+/**
+ * @brief  Find the monotonic time at which the RTC seconds register rolls over
+ * @note   If WaitSqwEdge is set, SQW/OUT must be set to DS13072_OutWave_1Hz.
+ *         The edge is checked against the seconds register before it is used
+ *         and UncertaintyUs is 0. Otherwise, or if the check fails, the
+ *         seconds register is polled over a few seconds at 100 ms, 10 ms and
+ *         1 ms intervals, each time around the edge predicted by the last
+ *         one. The polling search ends with an uncertainty of about half of
+ *         a read plus 0.5 ms.
+ * @note   If the read budget runs out after the first edge is found, the best
+ *         result so far is returned.
+ * @param  Handler: Pointer to handler
+ * @param  Sync: Pointer to synchronization parameters
+ * @param  Result: Pointer to store the result
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data, the clock is not
+ *                         running, or the read budget ran out before the
+ *                         first edge.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_SyncToSecondEdge(DS13072_Handler_t *Handler,
+                         const DS13072_Sync_t *Sync,
+                         DS13072_SyncResult_t *Result);
+#endif
+
+
 #ifdef __cplusplus
 }
 #endif
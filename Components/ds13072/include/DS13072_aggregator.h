@@ -0,0 +1,219 @@
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _DS13072_AGGREGATOR_H_
+#define _DS13072_AGGREGATOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdatomic.h>
+#include "DS13072.h"
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Maximum number of chips in an aggregator (1 to 8).
+ */
+#ifdef CONFIG_DS13072_AGGREGATOR_MAX_MEMBERS
+#define DS13072_AGGREGATOR_MAX_MEMBERS  CONFIG_DS13072_AGGREGATOR_MAX_MEMBERS
+#else
+#define DS13072_AGGREGATOR_MAX_MEMBERS  4
+#endif
+
+/**
+ * @brief  Default voting parameters.
+ * @note   TIMEOUT_MS: chips that have not answered by then are left out of
+ *         the vote. TOLERANCE_S: chips within this many seconds of the median
+ *         agree; chips set at different times easily differ by a second.
+ *         STUCK_MS: a chip whose time has not changed for this long while the
+ *         monotonic clock advanced is left out of the vote.
+ */
+#define DS13072_AGGREGATOR_TIMEOUT_MS   50
+#define DS13072_AGGREGATOR_TOLERANCE_S  2
+#define DS13072_AGGREGATOR_STUCK_MS     2500
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+
+struct DS13072_Aggregator_s;
+
+/**
+ * @brief  Function type for reading a monotonic clock in microseconds.
+ * @param  TimeUs: Pointer to store the time
+ * @retval
+ *         -  0: The operation was successful.
+ *         - -1: The operation failed.
+ */
+typedef int8_t (*DS13072_AggregatorGetUs_t)(uint64_t *TimeUs);
+
+/**
+ * @brief  Function type for reading all members concurrently.
+ * @note   Must call DS13072_Aggregator_ReadMember once for every member,
+ *         each from its own task, and return when all have returned or
+ *         TimeoutMs has passed. A member that is still busy with an earlier
+ *         read must not be started again.
+ * @param  Aggregator: Pointer to aggregator
+ * @param  TimeoutMs: Maximum time to wait in milliseconds
+ * @retval Bit mask of the members whose DS13072_Aggregator_ReadMember
+ *         returned in time
+ */
+typedef uint32_t (*DS13072_AggregatorReadAll_t)(
+    struct DS13072_Aggregator_s *Aggregator, uint32_t TimeoutMs);
+
+/**
+ * @brief  Voting confidence
+ */
+typedef enum DS13072_Confidence_e
+{
+  DS13072_Confidence_None     = 0,  // No majority of the chips agree
+  DS13072_Confidence_Majority = 1,  // More than half of the chips agree
+  DS13072_Confidence_All      = 2   // All chips answered and agree
+} DS13072_Confidence_t;
+
+/**
+ * @brief  Aggregator member, one per chip
+ * @note   The DS1307 address is fixed, so each chip is on its own bus and
+ *         its handler has its own platform functions, e.g. from
+ *         DS13072_Platform_InitPort.
+ */
+typedef struct DS13072_AggregatorMember_s
+{
+  // Initialized DS13072 handler
+  DS13072_Handler_t *Handler;
+
+  // Internal: last sample, written by DS13072_Aggregator_ReadMember
+  uint32_t Round;
+  uint32_t UnixTime;
+  uint64_t TimeUs;
+  DS13072_Result_t Result;
+
+  // Internal: time read at the last change and when it was seen
+  uint32_t LastUnixTime;
+  uint64_t LastChangeUs;
+  uint8_t HasLast;
+} DS13072_AggregatorMember_t;
+
+/**
+ * @brief  Aggregator handler
+ * @note   Call DS13072_Aggregator_Init, add the members, then set
+ *         GetMonotonicUs and ReadAll (or start the platform readers). The
+ *         parameters can be changed between reads; 0 selects the default.
+ */
+typedef struct DS13072_Aggregator_s
+{
+  // Reads a monotonic clock in microseconds
+  DS13072_AggregatorGetUs_t GetMonotonicUs;
+  // Reads all members concurrently
+  DS13072_AggregatorReadAll_t ReadAll;
+
+  // 0: DS13072_AGGREGATOR_TIMEOUT_MS
+  uint32_t TimeoutMs;
+  // 0: DS13072_AGGREGATOR_TOLERANCE_S
+  uint32_t ToleranceS;
+  // 0: DS13072_AGGREGATOR_STUCK_MS
+  uint32_t StuckMs;
+
+  // Internal: members
+  DS13072_AggregatorMember_t Members[DS13072_AGGREGATOR_MAX_MEMBERS];
+  uint8_t Count;
+  // Internal: number of the current read; readers that are late from an
+  // earlier read may load it while it changes
+  atomic_uint_fast32_t Round;
+} DS13072_Aggregator_t;
+
+/**
+ * @brief  Aggregated date and time
+ */
+typedef struct DS13072_AggregatorResult_s
+{
+  // Voted date and time (24-hour mode)
+  DS13072_DateTime_t DateTime;
+  // Voted date and time as Unix time
+  uint32_t UnixTime;
+  DS13072_Confidence_t Confidence;
+  // Bit masks of members, bit 0 for the first member added:
+  // agree with the result
+  uint8_t AgreeMask;
+  // failed, answered late or hold an invalid date and time
+  uint8_t FailedMask;
+  // time does not advance
+  uint8_t StuckMask;
+  // time of the concurrent read (us)
+  uint32_t LatencyUs;
+} DS13072_AggregatorResult_t;
+
+
+
+/**
+ ==================================================================================
+                             ##### Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize an aggregator with no members.
+ * @note   GetMonotonicUs, ReadAll and the parameters are not changed.
+ * @param  Aggregator: Pointer to aggregator
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ */
+DS13072_Result_t
+DS13072_Aggregator_Init(DS13072_Aggregator_t *Aggregator);
+
+
+/**
+ * @brief  Add a chip to the aggregator.
+ * @param  Aggregator: Pointer to aggregator
+ * @param  Handler: Initialized handler of the chip
+ * @param  Index: Pointer to store the member index (bit in the result masks);
+ *                can be NULL
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: The aggregator is full.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_Aggregator_AddMember(DS13072_Aggregator_t *Aggregator,
+                             DS13072_Handler_t *Handler, uint8_t *Index);
+
+
+/**
+ * @brief  Read the date and time of one member.
+ * @note   Called by ReadAll from the task of the member; only touches the
+ *         sample of that member.
+ * @param  Aggregator: Pointer to aggregator
+ * @param  Index: Member index
+ * @retval None
+ */
+void
+DS13072_Aggregator_ReadMember(DS13072_Aggregator_t *Aggregator, uint8_t Index);
+
+
+/**
+ * @brief  Read all chips concurrently and vote.
+ * @note   The result is the median of the chips that answered in time with a
+ *         valid, advancing date and time. Chips within ToleranceS of the
+ *         median agree; the others are outliers. Only one task may call this
+ *         function at a time.
+ * @param  Aggregator: Pointer to aggregator
+ * @param  Result: Pointer to store the result; the masks are set also when
+ *                 DS13072_FAIL is returned
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: No chip gave a usable date and time.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_Aggregator_Read(DS13072_Aggregator_t *Aggregator,
+                        DS13072_AggregatorResult_t *Result);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _DS13072_AGGREGATOR_H_
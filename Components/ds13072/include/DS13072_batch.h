@@ -0,0 +1,119 @@
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _DS13072_BATCH_H_
+#define _DS13072_BATCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "DS13072.h"
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+
+/**
+ * @brief  Date and time records in structure-of-arrays layout (24-hour mode)
+ * @note   Each member points to an array with one element per record. Year is
+ *         0 to 99 (2000 to 2099) and WeekDay is 1 (Monday) to 7 (Sunday).
+ */
+typedef struct DS13072_DateTimeArrays_s
+{
+  uint8_t   *Second;
+  uint8_t   *Minute;
+  uint8_t   *Hour;
+  uint8_t   *WeekDay;
+  uint8_t   *Day;
+  uint8_t   *Month;
+  uint8_t   *Year;
+} DS13072_DateTimeArrays_t;
+
+
+/* Exported Macro ---------------------------------------------------------------*/
+/**
+ * @brief  Number of uint32_t words needed for the validity bitmap of Count
+ *         records. Bit (i % 32) of word (i / 32) is set if record i is valid.
+ */
+#define DS13072_BATCH_BITMAP_WORDS(Count)  (((Count) + 31) / 32)
+
+
+
+/**
+ ==================================================================================
+                          ##### Batch Conversion Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Convert raw register snapshots to Unix time.
+ * @note   Each snapshot is the 7-byte burst read from the SECOND register
+ *         onwards, decoded the same way as DS13072_RegsToDateTime.
+ * @note   A record is invalid if a BCD digit is out of range or the date and
+ *         time do not exist, or if it is in 12-hour mode and
+ *         DS13072_USE_12HOUR is 0; its UnixTime is undefined.
+ * @param  Regs: Array of register snapshots
+ * @param  UnixTime: Array to store the results (seconds since 1970)
+ * @param  Valid: Validity bitmap, DS13072_BATCH_BITMAP_WORDS(Count) words
+ * @param  Count: Number of records
+ * @retval Number of valid records
+ */
+uint32_t
+DS13072_Batch_RegsToUnix(const uint8_t (*Regs)[7], uint32_t *UnixTime,
+                         uint32_t *Valid, uint32_t Count);
+
+
+/**
+ * @brief  Convert date and time structures to Unix time.
+ * @note   Same rules as DS13072_DateTimeToUnix; invalid records get their
+ *         bit cleared instead of stopping the conversion.
+ * @param  DateTime: Array of date and time value structures
+ * @param  UnixTime: Array to store the results (seconds since 1970)
+ * @param  Valid: Validity bitmap, DS13072_BATCH_BITMAP_WORDS(Count) words
+ * @param  Count: Number of records
+ * @retval Number of valid records
+ */
+uint32_t
+DS13072_Batch_DateTimeToUnix(const DS13072_DateTime_t *DateTime,
+                             uint32_t *UnixTime, uint32_t *Valid,
+                             uint32_t Count);
+
+
+/**
+ * @brief  Convert date and time arrays to Unix time.
+ * @note   WeekDay is not used and may be NULL.
+ * @param  Arrays: Date and time records in structure-of-arrays layout
+ * @param  UnixTime: Array to store the results (seconds since 1970)
+ * @param  Valid: Validity bitmap, DS13072_BATCH_BITMAP_WORDS(Count) words
+ * @param  Count: Number of records
+ * @retval Number of valid records
+ */
+uint32_t
+DS13072_Batch_ArraysToUnix(const DS13072_DateTimeArrays_t *Arrays,
+                           uint32_t *UnixTime, uint32_t *Valid,
+                           uint32_t Count);
+
+
+/**
+ * @brief  Convert Unix time to date and time arrays.
+ * @note   Records outside 2000 to 2099 are invalid; their fields are
+ *         undefined.
+ * @param  UnixTime: Array of Unix times (seconds since 1970)
+ * @param  Arrays: Date and time records in structure-of-arrays layout
+ * @param  Valid: Validity bitmap, DS13072_BATCH_BITMAP_WORDS(Count) words
+ * @param  Count: Number of records
+ * @retval Number of valid records
+ */
+uint32_t
+DS13072_Batch_UnixToArrays(const uint32_t *UnixTime,
+                           const DS13072_DateTimeArrays_t *Arrays,
+                           uint32_t *Valid, uint32_t Count);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _DS13072_BATCH_H_
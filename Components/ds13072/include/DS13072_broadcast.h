@@ -0,0 +1,176 @@
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _DS13072_BROADCAST_H_
+#define _DS13072_BROADCAST_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "DS13072.h"
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Maximum number of tasks that can subscribe to notifications.
+ * @note   Tasks that only call DS13072_Broadcast_Read do not need a slot.
+ */
+#ifdef CONFIG_DS13072_BROADCAST_MAX_SUBSCRIBERS
+#define DS13072_BROADCAST_MAX_SUBSCRIBERS  CONFIG_DS13072_BROADCAST_MAX_SUBSCRIBERS
+#else
+#define DS13072_BROADCAST_MAX_SUBSCRIBERS  16
+#endif
+
+/**
+ * @brief  Number of published samples kept. Must be a power of 2 and at
+ *         least 2; larger values let slow readers copy without retrying.
+ */
+#define DS13072_BROADCAST_RING_SIZE        4
+
+/**
+ * @brief  The publisher wakes up this many ticks before the earliest expected
+ *         second edge and polls the seconds register until it changes. Two
+ *         ticks cover the tick the last edge was seen in and the wake-up
+ *         jitter at any tick rate.
+ */
+#define DS13072_BROADCAST_GUARD_TICKS      2
+
+/**
+ * @brief  Task notification index used to signal subscribers.
+ */
+#define DS13072_BROADCAST_NOTIFY_INDEX     0
+
+/**
+ * @brief  Publisher task stack size in bytes.
+ */
+#define DS13072_BROADCAST_STACK_SIZE       2560
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+
+/**
+ * @brief  Broadcast handler
+ * @note   Set Handler, then call DS13072_Broadcast_Start. All other fields
+ *         are managed by the library.
+ */
+typedef struct DS13072_Broadcast_s
+{
+  // Initialized DS13072 handler, used only by the publisher task
+  DS13072_Handler_t *Handler;
+
+  // Internal: sequence number of the last published sample (0: none yet)
+  atomic_uint_fast32_t Sequence;
+  // Internal: published samples, indexed by Sequence
+  DS13072_DateTime_t Ring[DS13072_BROADCAST_RING_SIZE];
+
+  // Internal: subscribed tasks (NULL: free slot)
+  TaskHandle_t Subscribers[DS13072_BROADCAST_MAX_SUBSCRIBERS];
+  // Internal: stack of free subscriber slots
+  uint8_t FreeSlots[DS13072_BROADCAST_MAX_SUBSCRIBERS];
+  uint8_t FreeCount;
+  portMUX_TYPE Lock;
+
+  // Internal: publisher task
+  TaskHandle_t Task;
+  volatile uint8_t Running;
+} DS13072_Broadcast_t;
+
+
+
+/**
+ ==================================================================================
+                             ##### Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Start the publisher task.
+ * @note   The task finds the rollover of the seconds register with 1-byte
+ *         reads, then reads the date and time once and publishes it to all
+ *         readers. Once the edge is tracked this takes about
+ *         DS13072_BROADCAST_GUARD_TICKS + 2 short reads and one date and time
+ *         read per second. Other tasks can still use the handler, the bus
+ *         lock of the handler keeps their accesses apart, but they should
+ *         take the date and time from the broadcast instead of the chip.
+ * @param  Broadcast: Pointer to broadcast handler
+ * @param  Priority: FreeRTOS priority of the publisher task
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to create the task.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_Broadcast_Start(DS13072_Broadcast_t *Broadcast, UBaseType_t Priority);
+
+
+/**
+ * @brief  Stop the publisher task.
+ * @note   Returns after the task has exited. DS13072_Broadcast_Start clears
+ *         all subscriptions.
+ * @param  Broadcast: Pointer to broadcast handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ */
+DS13072_Result_t
+DS13072_Broadcast_Stop(DS13072_Broadcast_t *Broadcast);
+
+
+/**
+ * @brief  Register a task to be notified on every published second.
+ * @note   The task is signalled with xTaskNotifyGiveIndexed on
+ *         DS13072_BROADCAST_NOTIFY_INDEX; it should wait with
+ *         ulTaskNotifyTakeIndexed and then call DS13072_Broadcast_Read.
+ * @param  Broadcast: Pointer to broadcast handler
+ * @param  Task: Task to notify
+ * @param  Id: Pointer to store the subscription id
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: All subscriber slots are in use.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_Broadcast_Subscribe(DS13072_Broadcast_t *Broadcast,
+                            TaskHandle_t Task, uint8_t *Id);
+
+
+/**
+ * @brief  Remove a task registered by DS13072_Broadcast_Subscribe.
+ * @note   A notification of a second being published can still reach the
+ *         task just after this returns.
+ * @param  Broadcast: Pointer to broadcast handler
+ * @param  Id: Subscription id
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: Id is not subscribed.
+ */
+DS13072_Result_t
+DS13072_Broadcast_Unsubscribe(DS13072_Broadcast_t *Broadcast, uint8_t Id);
+
+
+/**
+ * @brief  Get the last published date and time without bus traffic.
+ * @note   Lock-free; can be called from any task at any rate.
+ * @param  Broadcast: Pointer to broadcast handler
+ * @param  DateTime: pointer to date and time value structure
+ * @param  Sequence: Pointer to store the sample sequence number, which
+ *         increases by one per published second (can be NULL)
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Nothing has been published yet.
+ */
+DS13072_Result_t
+DS13072_Broadcast_Read(DS13072_Broadcast_t *Broadcast,
+                       DS13072_DateTime_t *DateTime, uint32_t *Sequence);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _DS13072_BROADCAST_H_
@@ -0,0 +1,159 @@
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _DS13072_PACKED_H_
+#define _DS13072_PACKED_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "DS13072.h"
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+
+/**
+ * @brief  Packed date and time: seconds since 2000-01-01 00:00:00
+ * @note   Covers the whole 2000 to 2099 range of the chip and sorts as an
+ *         integer. Unix time = Packed + DS13072_PACKED_EPOCH.
+ */
+typedef uint32_t DS13072_Packed_t;
+
+
+/* Exported Constants -----------------------------------------------------------*/
+#define DS13072_PACKED_EPOCH    DS13072_UNIX_2000
+#define DS13072_PACKED_INVALID  0xFFFFFFFFUL // never produced by a conversion
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Event log in the Non-volatile RAM (1: compiled in, 0: compiled out)
+ * @note   Selected in menuconfig; outside ESP-IDF it follows
+ *         DS13072_USE_NVRAM.
+ */
+#if DS13072_USE_NVRAM && \
+    (!defined(ESP_PLATFORM) || defined(CONFIG_DS13072_EVENTLOG))
+#define DS13072_USE_EVENTLOG  1
+#else
+#define DS13072_USE_EVENTLOG  0
+#endif
+
+/**
+ * @brief  Event log location in the Non-volatile RAM.
+ * @note   The log takes 4 bytes of header plus 4 bytes per event; the area
+ *         must fit in the 56 bytes of RAM and must not be used for anything
+ *         else.
+ */
+#ifdef CONFIG_DS13072_EVENTLOG_CAPACITY
+#define DS13072_EVENTLOG_ADDRESS   CONFIG_DS13072_EVENTLOG_ADDRESS
+#define DS13072_EVENTLOG_CAPACITY  CONFIG_DS13072_EVENTLOG_CAPACITY
+#else
+#define DS13072_EVENTLOG_ADDRESS   0
+#define DS13072_EVENTLOG_CAPACITY  13
+#endif
+
+
+
+/**
+ ==================================================================================
+                          ##### Packed Time Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Pack date and time into 32 bits
+ * @param  DateTime: pointer to date and time value structure
+ * @param  Packed: pointer to store the result
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_Pack(const DS13072_DateTime_t *DateTime, DS13072_Packed_t *Packed);
+
+
+/**
+ * @brief  Pack a raw register snapshot into 32 bits
+ * @param  Regs: 7-byte burst read from the SECOND register onwards
+ * @param  Packed: pointer to store the result
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: Registers do not hold a valid date and time.
+ */
+DS13072_Result_t
+DS13072_PackRegs(const uint8_t Regs[7], DS13072_Packed_t *Packed);
+
+
+/**
+ * @brief  Unpack 32 bits into date and time in 24-hour mode
+ * @param  Packed: packed date and time
+ * @param  DateTime: pointer to date and time value structure
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: Packed is after 2099.
+ */
+DS13072_Result_t
+DS13072_Unpack(DS13072_Packed_t Packed, DS13072_DateTime_t *DateTime);
+
+
+
+#if DS13072_USE_EVENTLOG
+/**
+ ==================================================================================
+                           ##### Event Log Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Prepare the event log in Non-volatile RAM
+ * @note   An existing log is kept. If the area does not hold a log with the
+ *         configured capacity (first use, or lost backup power), an empty
+ *         log is written.
+ * @param  Handler: Pointer to handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data.
+ */
+DS13072_Result_t
+DS13072_EventLog_Init(DS13072_Handler_t *Handler);
+
+
+/**
+ * @brief  Add an event to the log
+ * @note   When the log is full the oldest event is overwritten.
+ * @param  Handler: Pointer to handler
+ * @param  Packed: packed date and time of the event
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data, or the log is not
+ *                         initialized.
+ */
+DS13072_Result_t
+DS13072_EventLog_Append(DS13072_Handler_t *Handler, DS13072_Packed_t Packed);
+
+
+/**
+ * @brief  Read all events in the log, newest first
+ * @note   The whole log is read in one burst.
+ * @param  Handler: Pointer to handler
+ * @param  Events: Array of DS13072_EVENTLOG_CAPACITY elements
+ * @param  Count: Pointer to store the number of events read
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data, or the log is not
+ *                         initialized.
+ */
+DS13072_Result_t
+DS13072_EventLog_Read(DS13072_Handler_t *Handler,
+                      DS13072_Packed_t *Events, uint8_t *Count);
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _DS13072_PACKED_H_
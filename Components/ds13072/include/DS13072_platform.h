@@ -41,13 +41,31 @@ extern "C" {
 
 /* Includes ---------------------------------------------------------------------*/
 #include "DS13072.h"
+#include "driver/i2c.h"
+#ifdef CONFIG_DS13072_SYSCLOCK
+#include "DS13072_sysclock.h"
+#endif
+#ifdef CONFIG_DS13072_TRACE
+#include "DS13072_trace.h"
+#endif
+#ifdef CONFIG_DS13072_AGGREGATOR
+#include "freertos/FreeRTOS.h"
+#include "DS13072_aggregator.h"
+#endif
 
 
 /* Functionality Options --------------------------------------------------------*/
+#ifdef CONFIG_DS13072_I2C_NUM
+#define DS13072_I2C_NUM   CONFIG_DS13072_I2C_NUM
+#define DS13072_I2C_RATE  CONFIG_DS13072_I2C_RATE
+#define DS13072_SCL_GPIO  CONFIG_DS13072_SCL_GPIO
+#define DS13072_SDA_GPIO  CONFIG_DS13072_SDA_GPIO
+#else
 #define DS13072_I2C_NUM   I2C_NUM_0
 #define DS13072_I2C_RATE  100000
 #define DS13072_SCL_GPIO  GPIO_NUM_9
 #define DS13072_SDA_GPIO  GPIO_NUM_8
+#endif
 
 
 
@@ -59,11 +77,129 @@ extern "C" {
 
 /**
  * @brief  Initialize platform device to communicate DS13072.
+ * @note   Uses the I2C port and GPIOs of the configuration.
+ * @param  Handler: Pointer to handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to create the mutex.
+ *         - DS13072_INVALID_PARAM: The configured port is not an I2C port of
+ *           the chip.
+ */
+DS13072_Result_t
+DS13072_Platform_Init(DS13072_Handler_t *Handler);
+
+
+/**
+ * @brief  Initialize platform device to communicate DS13072 on an I2C port.
+ * @note   Each port has its own platform functions, so one DS13072 per port
+ *         can be used at the same time. The bus rate is DS13072_I2C_RATE.
+ *         The port driver is installed by DS13072_Init.
+ * @note   The register accesses of all tasks that use the handler are
+ *         serialized with a mutex of the port.
+ * @param  Handler: Pointer to handler
+ * @param  Port: I2C port
+ * @param  Sda: SDA GPIO
+ * @param  Scl: SCL GPIO
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to create the mutex.
+ *         - DS13072_INVALID_PARAM: Port is not an I2C port of the chip.
+ */
+DS13072_Result_t
+DS13072_Platform_InitPort(DS13072_Handler_t *Handler, i2c_port_t Port,
+                          gpio_num_t Sda, gpio_num_t Scl);
+
+
+#ifdef CONFIG_DS13072_SYSCLOCK
+/**
+ * @brief  Initialize the system clock layer of a system clock handler.
+ * @note   Uses gettimeofday()/settimeofday() and esp_timer. A held-back
+ *         write-back is flushed by a low priority task that an esp_timer
+ *         callback wakes, and DS13072_SysClock_Update is serialized with a
+ *         mutex. Handler and the write-back policy fields are not changed.
+ *         Only one system clock handler is supported.
+ * @param  SysClock: Pointer to system clock handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to create the timer, the task or the mutex.
+ */
+DS13072_Result_t
+DS13072_SysClock_Platform_Init(DS13072_SysClock_t *SysClock);
+#endif
+
+
+#ifdef CONFIG_DS13072_TRACE
+/**
+ * @brief  Start recording the transfers of a handler, timestamped with
+ *         esp_timer.
  * @param  Handler: Pointer to handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: A handler is already traced.
+ */
+DS13072_Result_t
+DS13072_Trace_Platform_Attach(DS13072_Handler_t *Handler);
+
+
+/**
+ * @brief  Print the recorded transfers on the console.
+ * @note   The binary dump is printed as hex in lines starting with
+ *         "DS13072_TRACE:", which the replay tool reads from a console log.
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ */
+DS13072_Result_t
+DS13072_Trace_Platform_DumpConsole(void);
+
+
+/**
+ * @brief  Store the recorded transfers as a blob in NVS.
+ * @note   NVS must be initialized (nvs_flash_init) by the application.
+ * @param  Namespace: NVS namespace
+ * @param  Key: NVS key of the blob
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to allocate memory or to write NVS.
+ */
+DS13072_Result_t
+DS13072_Trace_Platform_DumpNVS(const char *Namespace, const char *Key);
+#endif
+
+
+#if DS13072_USE_SYNC
+/**
+ * @brief  Initialize the platform functions of second-edge synchronization.
+ * @note   Uses esp_timer. If CONFIG_DS13072_SYNC_SQW_GPIO is set, the falling
+ *         edge of SQW/OUT is captured on that GPIO; the edge polarity is
+ *         checked by DS13072_SyncToSecondEdge. MaxReads is not changed.
+ * @param  Sync: Pointer to synchronization parameters
  * @retval None
  */
 void
-DS13072_Platform_Init(DS13072_Handler_t *Handler);
+DS13072_Sync_Platform_Init(DS13072_Sync_t *Sync);
+#endif
+
+
+#ifdef CONFIG_DS13072_AGGREGATOR
+/**
+ * @brief  Start one reader task per member and set the platform functions of
+ *         the aggregator.
+ * @note   Call after all members are added. Each read wakes the reader tasks
+ *         and waits for them on an event group; a task blocked on a failed
+ *         bus is not woken again until it returns. Only one aggregator is
+ *         supported.
+ * @param  Aggregator: Pointer to aggregator
+ * @param  Priority: FreeRTOS priority of the reader tasks
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to create the tasks or the event group, or
+ *                         the tasks are already started.
+ *         - DS13072_INVALID_PARAM: The aggregator has no members.
+ */
+DS13072_Result_t
+DS13072_Aggregator_Platform_Start(DS13072_Aggregator_t *Aggregator,
+                                  UBaseType_t Priority);
+#endif
 
 
 #ifdef __cplusplus
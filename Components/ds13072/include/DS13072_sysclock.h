@@ -0,0 +1,171 @@
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _DS13072_SYSCLOCK_H_
+#define _DS13072_SYSCLOCK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "DS13072.h"
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+
+/**
+ * @brief  Function type for reading a clock of the system clock layer.
+ * @param  TimeMs: Pointer to store the time in milliseconds
+ * @retval
+ *         -  0: The operation was successful.
+ *         - -1: The operation failed.
+ */
+typedef int8_t (*DS13072_SysClockGet_t)(uint64_t *TimeMs);
+
+/**
+ * @brief  Function type for setting the system wall clock.
+ * @param  TimeMs: Milliseconds since 1970-01-01 00:00:00
+ * @retval
+ *         -  0: The operation was successful.
+ *         - -1: The operation failed.
+ */
+typedef int8_t (*DS13072_SysClockSet_t)(uint64_t TimeMs);
+
+/**
+ * @brief  Function type for calling DS13072_SysClock_Update once after a delay.
+ * @note   A new call replaces the pending one. The call must not be made
+ *         before DelayMs has passed on the monotonic clock; it is requested
+ *         only once per held-back write-back.
+ * @param  DelayMs: Time to wait in milliseconds
+ * @retval
+ *         -  0: The operation was successful.
+ *         - -1: The operation failed.
+ */
+typedef int8_t (*DS13072_SysClockSchedule_t)(uint32_t DelayMs);
+
+/**
+ * @brief  Function type for taking/releasing the lock of the handler.
+ */
+typedef void (*DS13072_SysClockLock_t)(void);
+
+/**
+ * @brief  System clock integration handler
+ * @note   The clock layer functions and Handler must be set before calling
+ *         DS13072_SysClock_Init. Fields marked as internal are managed by the
+ *         library.
+ */
+typedef struct DS13072_SysClock_s
+{
+  // Initialized DS13072 handler
+  DS13072_Handler_t *Handler;
+  // Reads the system wall clock (ms since 1970-01-01 00:00:00)
+  DS13072_SysClockGet_t GetSystemTime;
+  // Sets the system wall clock (ms since 1970-01-01 00:00:00)
+  DS13072_SysClockSet_t SetSystemTime;
+  // Reads a monotonic clock in ms that is not affected by SetSystemTime
+  DS13072_SysClockGet_t GetMonotonicTime;
+  // Calls DS13072_SysClock_Update after a delay to flush a rate-limited
+  // write-back; NULL: the application calls DS13072_SysClock_Update
+  // periodically
+  DS13072_SysClockSchedule_t Schedule;
+  // Serialize DS13072_SysClock_Update when it is called from more than one
+  // task (e.g. SNTP callback and the Schedule timer); can be NULL
+  DS13072_SysClockLock_t Lock;
+  DS13072_SysClockLock_t Unlock;
+
+  // Divergence between system clock and RTC that triggers a write-back (ms)
+  // 0: DS13072_SYSCLOCK_THRESHOLD_MS
+  uint32_t ThresholdMs;
+  // Minimum time between two write-backs to the RTC (ms); also the interval
+  // at which the RTC is read back to follow its drift
+  // 0: DS13072_SYSCLOCK_MIN_INTERVAL_MS
+  uint32_t MinIntervalMs;
+
+  // Internal: RTC time minus monotonic time at the last RTC sync (ms)
+  int64_t RtcOffsetMs;
+  // Internal: monotonic time of the last RTC write (ms)
+  uint64_t LastWriteMs;
+  // Internal: monotonic time of the last RTC read or write (ms)
+  uint64_t LastSyncMs;
+  // Internal: number of writes to the RTC since init
+  uint32_t WriteCount;
+  // Internal: RTC holds a valid time; RtcOffsetMs can be used
+  uint8_t RtcValid;
+  // Internal: at least one write to the RTC has been done
+  uint8_t Written;
+  // Internal: a write-back was held back by MinIntervalMs and is due at
+  // LastWriteMs + MinIntervalMs; Schedule has been called for it
+  uint8_t Pending;
+} DS13072_SysClock_t;
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Default write-back threshold and rate limit.
+ * @note   The RTC has 1 second resolution, so the threshold should not be set
+ *         below 1000 ms.
+ */
+#ifdef CONFIG_DS13072_SYSCLOCK_THRESHOLD_MS
+#define DS13072_SYSCLOCK_THRESHOLD_MS     CONFIG_DS13072_SYSCLOCK_THRESHOLD_MS
+#define DS13072_SYSCLOCK_MIN_INTERVAL_MS  CONFIG_DS13072_SYSCLOCK_MIN_INTERVAL_MS
+#else
+#define DS13072_SYSCLOCK_THRESHOLD_MS     2000
+#define DS13072_SYSCLOCK_MIN_INTERVAL_MS  60000
+#endif
+
+
+
+/**
+ ==================================================================================
+                             ##### Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Seed the system clock from the RTC.
+ * @note   After it returns, the application can use time()/gettimeofday()
+ *         without any bus traffic.
+ * @note   If the RTC does not hold a valid date and time, the system clock is
+ *         not changed and the first call to DS13072_SysClock_Update writes
+ *         the system time to the RTC.
+ * @param  SysClock: Pointer to system clock handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to read the RTC or to set the system clock.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_SysClock_Init(DS13072_SysClock_t *SysClock);
+
+
+/**
+ * @brief  Write the system time back to the RTC if they have diverged.
+ * @note   Call this after settimeofday() or from the SNTP sync notification
+ *         callback. The RTC time is predicted from the monotonic clock; the
+ *         RTC is written only when the divergence exceeds ThresholdMs and the
+ *         last write is at least MinIntervalMs old.
+ * @note   A divergence held back by MinIntervalMs is pending: the system time
+ *         of the call at or after the deadline is written, so the last of a
+ *         burst of adjustments reaches the RTC. Schedule is called to make
+ *         that call; without Schedule, call this function periodically.
+ * @note   The RTC crystal drifts from the monotonic clock (about 1.7 s/day at
+ *         20 ppm), so the seconds register is read back at most once per
+ *         MinIntervalMs to correct the prediction.
+ * @param  SysClock: Pointer to system clock handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to read a clock, to read or write the RTC,
+ *                         or to schedule the held-back write.
+ *         - DS13072_INVALID_PARAM: System time is out of the RTC range.
+ */
+DS13072_Result_t
+DS13072_SysClock_Update(DS13072_SysClock_t *SysClock);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _DS13072_SYSCLOCK_H_
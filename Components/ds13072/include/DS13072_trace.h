@@ -0,0 +1,140 @@
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _DS13072_TRACE_H_
+#define _DS13072_TRACE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "DS13072.h"
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+
+/**
+ * @brief  Function type for reading the trace clock.
+ * @retval Free-running time in microseconds
+ */
+typedef uint32_t (*DS13072_TraceClock_t)(void);
+
+/**
+ * @brief  Function type for writing dumped trace data.
+ * @param  Context: Pointer passed to DS13072_Trace_Dump
+ * @param  Data: Pointer to data
+ * @param  Len: data len in Bytes
+ * @retval
+ *         -  0: The operation was successful.
+ *         - -1: The operation failed.
+ */
+typedef int8_t (*DS13072_TraceWrite_t)(void *Context,
+                                       const uint8_t *Data, uint16_t Len);
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Number of transfers kept in the trace ring. Must be a power of 2.
+ */
+#ifdef CONFIG_DS13072_TRACE_CAPACITY
+#define DS13072_TRACE_CAPACITY  CONFIG_DS13072_TRACE_CAPACITY
+#else
+#define DS13072_TRACE_CAPACITY  64
+#endif
+
+/**
+ * @brief  Maximum payload bytes stored per transfer; longer transfers are
+ *         truncated (the full length is still recorded).
+ */
+#define DS13072_TRACE_PAYLOAD   DS13072_SEND_BUFFER_SIZE
+
+
+/* Trace Format -----------------------------------------------------------------*/
+/**
+ * @brief  Binary dump format (all values little-endian)
+ *         Header, 8 bytes:
+ *           - Magic "DSTR"
+ *           - Version (1 byte)
+ *           - DS13072_TRACE_PAYLOAD (1 byte)
+ *           - Reserved (2 bytes)
+ *         Followed by records, oldest first, until the end of the dump:
+ *           - Sequence number (4 bytes)
+ *           - Start time in us (4 bytes)
+ *           - Duration in us, saturated at 65535 (2 bytes)
+ *           - Address (1 byte), bit 7 set for receive
+ *           - Transfer length (1 byte)
+ *           - Result of the platform function (1 byte, signed)
+ *           - Stored payload length N (1 byte)
+ *           - Payload (N bytes)
+ */
+#define DS13072_TRACE_MAGIC        "DSTR"
+#define DS13072_TRACE_VERSION      1
+#define DS13072_TRACE_HEADER_SIZE  8
+#define DS13072_TRACE_RECORD_SIZE  14   // without payload
+#define DS13072_TRACE_READ         0x80
+
+
+
+/**
+ ==================================================================================
+                             ##### Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Start recording the transfers of a handler.
+ * @note   The PlatformSend and PlatformReceive functions of the handler are
+ *         wrapped; call this after the platform layer is set and before other
+ *         tasks use the handler. Only one handler can be traced at a time.
+ * @param  Handler: Pointer to handler
+ * @param  Clock: Microsecond clock used for timestamps
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: A handler is already traced or one of
+ *                                  parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_Trace_Attach(DS13072_Handler_t *Handler, DS13072_TraceClock_t Clock);
+
+
+/**
+ * @brief  Stop recording and restore the platform functions of the handler.
+ * @note   Recorded transfers are kept and can still be dumped.
+ * @param  Handler: Pointer to handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: Handler is not traced.
+ */
+DS13072_Result_t
+DS13072_Trace_Detach(DS13072_Handler_t *Handler);
+
+
+/**
+ * @brief  Discard all recorded transfers.
+ * @retval None
+ */
+void
+DS13072_Trace_Clear(void);
+
+
+/**
+ * @brief  Write recorded transfers in the binary dump format.
+ * @note   Lock-free; recording continues while dumping, and records that are
+ *         overwritten during the dump are skipped.
+ * @param  Write: Function that receives the dump in chunks
+ * @param  Context: Pointer passed to Write
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Write failed.
+ */
+DS13072_Result_t
+DS13072_Trace_Dump(DS13072_TraceWrite_t Write, void *Context);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _DS13072_TRACE_H_
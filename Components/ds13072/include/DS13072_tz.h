@@ -0,0 +1,169 @@
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _DS13072_TZ_H_
+#define _DS13072_TZ_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "DS13072.h"
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+
+/**
+ * @brief  DST transition rule, POSIX "Mm.w.d/time" form
+ */
+typedef struct DS13072_TZRule_s
+{
+  uint8_t   Month;    // 1 to 12
+  uint8_t   Week;     // 1 to 5, 5 = last week of the month
+  uint8_t   WeekDay;  // 0 (Sunday) to 6 (Saturday)
+  int32_t   Time;     // local time of the transition, seconds after 00:00
+} DS13072_TZRule_t;
+
+/**
+ * @brief  Compiled time zone
+ * @note   Offsets are seconds east of UTC (local = UTC + offset), which is
+ *         the opposite sign of the POSIX TZ string.
+ */
+typedef struct DS13072_TZ_s
+{
+  char              StdName[8];
+  char              DstName[8];
+  int32_t           StdOffset;
+  int32_t           DstOffset;
+  uint8_t           HasDst;
+  DS13072_TZRule_t  Start;  // standard to daylight, in standard local time
+  DS13072_TZRule_t  End;    // daylight to standard, in daylight local time
+} DS13072_TZ_t;
+
+/**
+ * @brief  Transitions of one year, kept by the caller
+ * @note   Zero-initialize before first use. One cache per zone and caller;
+ *         the cache is not thread-safe.
+ */
+typedef struct DS13072_TZCache_s
+{
+  const DS13072_TZ_t *Zone;
+  uint32_t  YearStart;  // Unix time of January 1st of the cached UTC year
+  uint32_t  YearEnd;    // Unix time of January 1st of the next year
+  uint32_t  DstStart;   // Unix time DST starts in the cached year
+  uint32_t  DstEnd;     // Unix time DST ends in the cached year
+} DS13072_TZCache_t;
+
+
+/* Exported Macro ---------------------------------------------------------------*/
+/**
+ * @brief  Define a zone without DST. Offset is in seconds east of UTC.
+ */
+#define DS13072_TZ_FIXED(Std, Offset) \
+  { Std, "", (Offset), (Offset), 0, {0, 0, 0, 0}, {0, 0, 0, 0} }
+
+/**
+ * @brief  Define a zone with DST, rules as in POSIX "Mm.w.d/time"
+ */
+#define DS13072_TZ_DST(Std, StdOff, Dst, DstOff,                      \
+                       SMonth, SWeek, SDay, STime,                    \
+                       EMonth, EWeek, EDay, ETime)                    \
+  { Std, Dst, (StdOff), (DstOff), 1,                                  \
+    {SMonth, SWeek, SDay, STime}, {EMonth, EWeek, EDay, ETime} }
+
+
+/* Exported Constants -----------------------------------------------------------*/
+/**
+ * @brief  Predefined zones, stored in flash
+ */
+extern const DS13072_TZ_t DS13072_TZ_UTC;            // UTC0
+extern const DS13072_TZ_t DS13072_TZ_CentralEurope;  // CET-1CEST,M3.5.0,M10.5.0/3
+extern const DS13072_TZ_t DS13072_TZ_UK;             // GMT0BST,M3.5.0/1,M10.5.0
+extern const DS13072_TZ_t DS13072_TZ_USEastern;      // EST5EDT,M3.2.0,M11.1.0
+extern const DS13072_TZ_t DS13072_TZ_USPacific;      // PST8PDT,M3.2.0,M11.1.0
+extern const DS13072_TZ_t DS13072_TZ_India;          // IST-5:30
+extern const DS13072_TZ_t DS13072_TZ_AUEastern;      // AEST-10AEDT,M10.1.0,M4.1.0/3
+
+
+
+/**
+ ==================================================================================
+                             ##### Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Compile a POSIX TZ string, e.g. "CET-1CEST,M3.5.0,M10.5.0/3"
+ * @note   Only the "Mm.w.d" rule form is supported. Names longer than 7
+ *         characters are truncated. Parse once at startup; conversions use
+ *         the compiled zone.
+ * @param  Posix: TZ string
+ * @param  Zone: pointer to store the compiled zone
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: String is not a supported TZ string.
+ */
+DS13072_Result_t
+DS13072_TZ_Parse(const char *Posix, DS13072_TZ_t *Zone);
+
+
+/**
+ * @brief  Convert UTC to local time
+ * @note   O(1) while UTC stays in the year held by the cache.
+ * @param  Zone: Pointer to zone
+ * @param  Cache: Pointer to transition cache of the caller
+ * @param  Utc: Unix time (2000 to 2099)
+ * @param  Local: pointer to store local time, as Unix time
+ * @param  IsDst: pointer to store 1 if DST is in effect (can be NULL)
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: Utc is outside 2000 to 2099.
+ */
+DS13072_Result_t
+DS13072_TZ_UtcToLocal(const DS13072_TZ_t *Zone, DS13072_TZCache_t *Cache,
+                      uint32_t Utc, uint32_t *Local, uint8_t *IsDst);
+
+
+/**
+ * @brief  Convert local time to UTC
+ * @note   A local time that occurs twice when DST ends is taken as daylight
+ *         time. A local time skipped when DST starts is taken as standard
+ *         time, like mktime() with tm_isdst = -1.
+ * @param  Zone: Pointer to zone
+ * @param  Cache: Pointer to transition cache of the caller
+ * @param  Local: local time, as Unix time
+ * @param  Utc: pointer to store Unix time
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: Result is outside 2000 to 2099.
+ */
+DS13072_Result_t
+DS13072_TZ_LocalToUtc(const DS13072_TZ_t *Zone, DS13072_TZCache_t *Cache,
+                      uint32_t Local, uint32_t *Utc);
+
+
+/**
+ * @brief  Get local date and time from the RTC, which keeps UTC
+ * @param  Handler: Pointer to handler
+ * @param  Zone: Pointer to zone
+ * @param  Cache: Pointer to transition cache of the caller
+ * @param  DateTime: pointer to date and time value structure (24-hour mode)
+ * @param  IsDst: pointer to store 1 if DST is in effect (can be NULL)
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data.
+ *         - DS13072_INVALID_PARAM: RTC does not hold a valid date and time.
+ */
+DS13072_Result_t
+DS13072_TZ_GetLocalDateTime(DS13072_Handler_t *Handler,
+                            const DS13072_TZ_t *Zone, DS13072_TZCache_t *Cache,
+                            DS13072_DateTime_t *DateTime, uint8_t *IsDst);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _DS13072_TZ_H_
@@ -1,46 +1,13 @@
 /* Includes ---------------------------------------------------------------------*/
 #include <string.h>
-#include "DS13072.h"
+#include "DS13072_private.h"
 
 
 /* Private Constants ------------------------------------------------------------*/
 /**
- * @brief  The DS13072 Address on I2C BUS
+ * @brief  Days from 1970-01-01 to 2000-01-01
  */ 
-#define DS13072_ADDRESS  0x68
-
-/**
- * @brief  Internal Registers Address
- */ 
-#define DS13072_SECOND   0x00  // the address of SECOND register in DS13072
-#define DS13072_MINUTE   0x01  // the address of MINUTE register in DS13072
-#define DS13072_HOUR     0x02  // the address of HOUR register in DS13072
-#define DS13072_DAY      0x03  // the address of DAY register in DS13072
-#define DS13072_DATE     0x04  // the address of DATE register in DS13072
-#define DS13072_MONTH    0x05  // the address of MONTH register in DS13072
-#define DS13072_YEAR     0x06  // the address of YEAR register in DS13072
-#define DS13072_CONTROL  0x07  // the address of CONTROL register in DS13072
-
-
-/**
- * @brief  Non-volatile RAM Address
- */ 
-#define DS13072_RAM      0x08  // the address of first byte of Non-volatile RAM
-#define DS13072_RAM_SIZE 56    // size of Non-volatile
-
-/**
- * @brief  CONTROL register bits
- */ 
-#define DS13072_OUT      7
-#define DS13072_SQWE     4
-#define DS13072_RS0      0
-#define DS13072_RS1      1
-
-
-/* Private Macro ----------------------------------------------------------------*/
-#ifndef MIN
-#define MIN(a, b) (((a) < (b)) ? (a) : (b))
-#endif
+#define DS13072_DAYS_TO_2000  10957
 
 
 /**
@@ -69,12 +36,22 @@ DS13072_BCDtoDEC(uint8_t BCD)
   return DEC;
 }
 
-static int8_t
+static uint8_t
+DS13072_BCDValid(uint8_t BCD)
+{
+  return ((BCD & 0x0f) < 10) && ((BCD >> 4) < 10);
+}
+
+int8_t
 DS13072_WriteRegs(DS13072_Handler_t *Handler,
                  uint8_t StartReg, uint8_t *Data, uint8_t BytesCount)
 {
   uint8_t Buffer[DS13072_SEND_BUFFER_SIZE];
   uint8_t Len = 0;
+  int8_t Result = 0;
+
+  if (Handler->PlatformLock)
+    Handler->PlatformLock();
 
   Buffer[0] = StartReg; // send register address to set RTC pointer
   while (BytesCount)
@@ -83,30 +60,41 @@ DS13072_WriteRegs(DS13072_Handler_t *Handler,
     memcpy((void*)(Buffer+1), (const void*)Data, Len);
 
     if (Handler->PlatformSend(DS13072_ADDRESS, Buffer, Len+1) < 0)
-      return -1;
+    {
+      Result = -1;
+      break;
+    }
 
     Data += Len;
     Buffer[0] += Len;
     BytesCount -= Len;
   }
 
-  return 0;
+  if (Handler->PlatformUnlock)
+    Handler->PlatformUnlock();
+
+  return Result;
 }
 
-static int8_t
+int8_t
 DS13072_ReadRegs(DS13072_Handler_t *Handler,
                 uint8_t StartReg, uint8_t *Data, uint8_t BytesCount)
 {
-  if (Handler->PlatformSend(DS13072_ADDRESS, &StartReg, 1) < 0)
-    return -1;
+  int8_t Result = 0;
 
-  if (Handler->PlatformReceive(DS13072_ADDRESS, Data, BytesCount) < 0)
-    return -1;
+  // the pointer write and the read must not be split by another access
+  if (Handler->PlatformLock)
+    Handler->PlatformLock();
 
-  return 0;
-}
+  if (Handler->PlatformSend(DS13072_ADDRESS, &StartReg, 1) < 0 ||
+      Handler->PlatformReceive(DS13072_ADDRESS, Data, BytesCount) < 0)
+    Result = -1;
 
+  if (Handler->PlatformUnlock)
+    Handler->PlatformUnlock();
 
+  return Result;
+}
 
 /**
  ==================================================================================
@@ -126,7 +114,8 @@ DS13072_Result_t
 DS13072_Init(DS13072_Handler_t *Handler)
 {
   if (!Handler->PlatformSend ||
-      !Handler->PlatformReceive)
+      !Handler->PlatformReceive ||
+      !Handler->PlatformLock != !Handler->PlatformUnlock)
     return DS13072_INVALID_PARAM;
 
   if (Handler->PlatformInit)
@@ -184,21 +173,21 @@ DS13072_SetDateTime(DS13072_Handler_t *Handler, DS13072_DateTime_t *DateTime)
       DateTime->Year > 99)
     return DS13072_INVALID_PARAM;
 
+#if !DS13072_USE_12HOUR
+  if (DateTime->HourMode == 1)
+    return DS13072_INVALID_PARAM;
+#endif
+
         // Convert to BCD
   Buffer[0] = DS13072_DECtoBCD(DateTime->Second) & 0x7F;
   Buffer[1] = DS13072_DECtoBCD(DateTime->Minute);
   Buffer[2] = DS13072_DECtoBCD(DateTime->Hour);
 
-  if(DateTime->HourMode == 1) {      // 12-hour mode
-        Buffer[2] |= (1 << 7);          // Set 12-hour mode
-      if(DateTime->isPM == true){
-        Buffer[2] |= (1<<6);  // set PM
-      }else{
-        Buffer[2] &= (1<<6); // set AM
-      }
-  }else{
-      Buffer[2] &= ~(1 << 7);
-  }
+#if DS13072_USE_12HOUR
+  if (DateTime->HourMode == 1 &&
+      DS13072_12Hour_ModeBits(DateTime, &Buffer[2]) != DS13072_OK)
+    return DS13072_INVALID_PARAM;
+#endif
   Buffer[3] = DS13072_DECtoBCD(DateTime->WeekDay);
   Buffer[4] = DS13072_DECtoBCD(DateTime->Day);
   Buffer[5] = DS13072_DECtoBCD(DateTime->Month);
@@ -227,145 +216,204 @@ DS13072_GetDateTime(DS13072_Handler_t *Handler, DS13072_DateTime_t *DateTime)
   if (DS13072_ReadRegs(Handler, DS13072_SECOND, Buffer, 7) < 0)
     return DS13072_FAIL;
 
-  // convert BCD value to decimal
-  DateTime->Second  = DS13072_BCDtoDEC(Buffer[0] & 0x7F);
-  DateTime->Minute  = DS13072_BCDtoDEC(Buffer[1]);
-  DateTime->WeekDay = DS13072_BCDtoDEC(Buffer[3]);
-  DateTime->Day     = DS13072_BCDtoDEC(Buffer[4]);
-  DateTime->Month   = DS13072_BCDtoDEC(Buffer[5]);
-  DateTime->Year    = DS13072_BCDtoDEC(Buffer[6]);
-    uint8_t hourReg = Buffer[2];
-    // 12-hour mode
-    if(hourReg & (1 << 7)) {
-        DateTime->isPM = (hourReg & (1<<6)) ? 1: 0;
-        DateTime->Hour = DS13072_BCDtoDEC(hourReg & 0x1F);  // bits 0-4
-    } else { // 24-hour mode
-        DateTime->Hour = DS13072_BCDtoDEC(hourReg & 0x3F);  // bits 0-5
-    }
-    return DS13072_OK;
+  // BCD errors show up as an invalid date and time
+  DS13072_RegsToDateTime(Buffer, DateTime);
+  return DS13072_OK;
 }
 
 
 /**
- ==================================================================================
-                       ##### Public Memory Functions #####                         
- ==================================================================================
- */
-
-/**
- * @brief  Write data on DS13072 data Non-volatile RAM
+ * @brief  Get the seconds from DS13072 real time chip
  * @param  Handler: Pointer to handler
- * @param  Address: address of block beginning (0 to 55)
- * @param  Data: pointer to data array
- * @param  Size: data size (1 to 56)
+ * @param  Second: pointer to store the seconds
  * @retval DS13072_Result_t
  *         - DS13072_OK: Operation was successful.
  *         - DS13072_FAIL: Failed to send or receive data.
- *         - DS13072_INVALID_PARAM: Requested area is out of range.
  */
 DS13072_Result_t
-DS13072_WriteRAM(DS13072_Handler_t *Handler,
-                uint8_t Address, uint8_t *Data, uint8_t Size)
+DS13072_GetSecond(DS13072_Handler_t *Handler, uint8_t *Second)
 {
-  Address += 8;
-
-  if ((Address + Size) > 0x3f)
-    return DS13072_INVALID_PARAM;
+  uint8_t Reg = 0;
 
-  if (DS13072_WriteRegs(Handler, Address, Data, Size) < 0)
+  if (DS13072_ReadRegs(Handler, DS13072_SECOND, &Reg, 1) < 0)
     return DS13072_FAIL;
 
+  *Second = DS13072_BCDtoDEC(Reg & 0x7F);
   return DS13072_OK;
 }
 
 
+
 /**
- * @brief  Read data from DS13072 data Non-volatile RAM
- * @param  Handler: Pointer to handler
- * @param  Address: address of block beginning (0 to 55)
- * @param  Data: pointer to data array
- * @param  Size: data size (1 to 56)
+ ==================================================================================
+                      ##### Public Conversion Functions #####                      
+ ==================================================================================
+ */
+
+/**
+ * @brief  Decode the date and time registers
+ * @param  Regs: 7-byte burst read from the SECOND register onwards
+ * @param  DateTime: pointer to date and time value structure
  * @retval DS13072_Result_t
  *         - DS13072_OK: Operation was successful.
- *         - DS13072_FAIL: Failed to send or receive data.
- *         - DS13072_INVALID_PARAM: Requested area is out of range.
+ *         - DS13072_INVALID_PARAM: A BCD digit is out of range.
  */
 DS13072_Result_t
-DS13072_ReadRAM(DS13072_Handler_t *Handler,
-               uint8_t Address, uint8_t *Data, uint8_t Size)
+DS13072_RegsToDateTime(const uint8_t Regs[7], DS13072_DateTime_t *DateTime)
 {
-  Address += 8;
+  uint8_t HourReg = Regs[2];
+  uint8_t Hour;
 
-  if ((Address + Size) > 0x3f)
-    return DS13072_INVALID_PARAM;
+  if (HourReg & (1 << DS13072_HOUR_12H))
+  {
+    // 12-hour mode
+    DateTime->HourMode = 1;
+    DateTime->isPM = (HourReg >> DS13072_HOUR_PM) & 1;
+    Hour = HourReg & 0x1F;  // bits 0-4
+  }
+  else
+  {
+    // 24-hour mode
+    DateTime->HourMode = 0;
+    DateTime->isPM = 0;
+    Hour = HourReg & 0x3F;  // bits 0-5
+  }
 
-  if (DS13072_ReadRegs(Handler, Address, Data, Size) < 0)
-    return DS13072_FAIL;
+  // convert BCD value to decimal
+  DateTime->Second  = DS13072_BCDtoDEC(Regs[0] & 0x7F);
+  DateTime->Minute  = DS13072_BCDtoDEC(Regs[1]);
+  DateTime->Hour    = DS13072_BCDtoDEC(Hour);
+  DateTime->WeekDay = DS13072_BCDtoDEC(Regs[3]);
+  DateTime->Day     = DS13072_BCDtoDEC(Regs[4]);
+  DateTime->Month   = DS13072_BCDtoDEC(Regs[5]);
+  DateTime->Year    = DS13072_BCDtoDEC(Regs[6]);
+
+  if (!DS13072_BCDValid(Regs[0] & 0x7F) ||
+      !DS13072_BCDValid(Regs[1]) ||
+      !DS13072_BCDValid(Hour) ||
+      !DS13072_BCDValid(Regs[4]) ||
+      !DS13072_BCDValid(Regs[5]) ||
+      !DS13072_BCDValid(Regs[6]))
+    return DS13072_INVALID_PARAM;
 
   return DS13072_OK;
 }
 
 
-
 /**
- ==================================================================================
-                     ##### Public Out Wave Functions #####                         
- ==================================================================================
- */
-
-/**
- * @brief  Set output Wave on SQW/Out pin of DS13072
- * @param  Handler: Pointer to handler
- * @param  OutWave: where OutWave Shows different output wave states
- *         - DS13072_OutWave_Low:    Logic level 0 on the SQW/OUT pin
- *         - DS13072_OutWave_High:   Logic level 1 on the SQW/OUT pin
- *         - DS13072_OutWave_1Hz:    Output wave frequency = 1Hz
- *         - DS13072_OutWave_4KHz:   Output wave frequency = 4.096KHz
- *         - DS13072_OutWave_8KHz:   Output wave frequency = 8.192KHz
- *         - DS13072_OutWave_32KHz:  Output wave frequency = 32.768KHz
- * 
+ * @brief  Convert date and time to Unix time (seconds since 1970-01-01 00:00:00)
+ * @note   The year is taken as 2000 + DateTime->Year. In 12-hour mode (HourMode
+ *         = 1) the Hour field must be 1 to 12 and isPM selects AM/PM.
+ * @note   WeekDay is not checked and does not take part in the conversion.
+ * @param  DateTime: pointer to date and time value structure
+ * @param  UnixTime: pointer to store the result
  * @retval DS13072_Result_t
  *         - DS13072_OK: Operation was successful.
- *         - DS13072_FAIL: Failed to send or receive data.
  *         - DS13072_INVALID_PARAM: One of parameters is invalid.
  */
 DS13072_Result_t
-DS13072_SetOutWave(DS13072_Handler_t *Handler, DS13072_OutWave_t OutWave)
+DS13072_DateTimeToUnix(const DS13072_DateTime_t *DateTime, uint32_t *UnixTime)
 {
-  uint8_t ControlReg;
-
-  switch (OutWave)
+  static const uint16_t DaysBeforeMonth[12] =
+    {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+  static const uint8_t DaysInMonth[12] =
+    {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  uint8_t Hour = DateTime->Hour;
+  uint8_t Leap;
+  uint32_t Days;
+
+  if (DateTime->HourMode == 1)
   {
-  case DS13072_OutWave_Low:
-    ControlReg = 0;
-    break;
+#if DS13072_USE_12HOUR
+    if (DS13072_12Hour_To24(DateTime, &Hour) != DS13072_OK)
+      return DS13072_INVALID_PARAM;
+#else
+    return DS13072_INVALID_PARAM;
+#endif
+  }
 
-  case DS13072_OutWave_High:
-    ControlReg = (1 << DS13072_OUT);
-    break;
+  if (DateTime->Second > 59 ||
+      DateTime->Minute > 59 ||
+      Hour > 23 ||
+      DateTime->Month > 12 || DateTime->Month == 0 ||
+      DateTime->Year > 99)
+    return DS13072_INVALID_PARAM;
+
+  // 2000 is a leap year, 2100 is out of range: every 4th year is leap
+  Leap = ((DateTime->Year & 3) == 0);
+  if (DateTime->Day == 0 ||
+      DateTime->Day > DaysInMonth[DateTime->Month - 1] +
+                      (DateTime->Month == 2 ? Leap : 0))
+    return DS13072_INVALID_PARAM;
 
-  case DS13072_OutWave_1Hz:
-    ControlReg = (1 << DS13072_SQWE);
-    break;
+  Days = DS13072_DAYS_TO_2000 +
+         DateTime->Year * 365UL + (DateTime->Year + 3) / 4 +
+         DaysBeforeMonth[DateTime->Month - 1] +
+         (DateTime->Month > 2 ? Leap : 0) +
+         DateTime->Day - 1;
 
-  case DS13072_OutWave_4KHz:
-    ControlReg = (1 << DS13072_SQWE) | (1 << DS13072_RS0);
-    break;
+  *UnixTime = Days * 86400UL +
+              Hour * 3600UL + DateTime->Minute * 60UL + DateTime->Second;
 
-  case DS13072_OutWave_8KHz:
-    ControlReg = (1 << DS13072_SQWE) | (1 << DS13072_RS1);
-    break;
+  return DS13072_OK;
+}
 
-  case DS13072_OutWave_32KHz:
-    ControlReg = (1 << DS13072_SQWE) | (3 << DS13072_RS0);
-    break;
 
-  default:
+/**
+ * @brief  Convert Unix time to date and time in 24-hour mode
+ * @note   WeekDay is set from 1 (Monday) to 7 (Sunday).
+ * @param  UnixTime: seconds since 1970-01-01 00:00:00 (2000 to 2099 only)
+ * @param  DateTime: pointer to date and time value structure
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: UnixTime is outside 2000 to 2099.
+ */
+DS13072_Result_t
+DS13072_UnixToDateTime(uint32_t UnixTime, DS13072_DateTime_t *DateTime)
+{
+  static const uint8_t DaysInMonth[12] =
+    {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  uint32_t Days;
+  uint32_t Secs;
+  uint8_t Year;
+  uint8_t Month;
+  uint16_t YearDays;
+
+  if (UnixTime < DS13072_UNIX_2000 || UnixTime >= DS13072_UNIX_2100)
     return DS13072_INVALID_PARAM;
+
+  Days = UnixTime / 86400UL;
+  Secs = UnixTime % 86400UL;
+
+  DateTime->Hour     = Secs / 3600;
+  DateTime->Minute   = (Secs / 60) % 60;
+  DateTime->Second   = Secs % 60;
+  DateTime->HourMode = 0;
+  DateTime->isPM     = 0;
+  DateTime->WeekDay  = ((Days + 3) % 7) + 1; // 1970-01-01 was a Thursday
+
+  // split into 4-year cycles; each cycle starts with a leap year
+  Days -= DS13072_DAYS_TO_2000;
+  Year = (Days / 1461) * 4;
+  Days %= 1461;
+  if (Days >= 366)
+  {
+    Days -= 366;
+    Year += 1 + Days / 365;
+    Days %= 365;
   }
 
-  if (DS13072_WriteRegs(Handler, DS13072_CONTROL, &ControlReg, 1) < 0)
-    return DS13072_FAIL;
+  for (Month = 0; Month < 11; Month++)
+  {
+    YearDays = DaysInMonth[Month] + ((Month == 1 && (Year & 3) == 0) ? 1 : 0);
+    if (Days < YearDays)
+      break;
+    Days -= YearDays;
+  }
+
+  DateTime->Year  = Year;
+  DateTime->Month = Month + 1;
+  DateTime->Day   = Days + 1;
 
   return DS13072_OK;
-}
\ No newline at end of file
+}
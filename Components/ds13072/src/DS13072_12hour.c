@@ -0,0 +1,37 @@
+/* Includes ---------------------------------------------------------------------*/
+#include "DS13072_private.h"
+
+
+
+/**
+ ==================================================================================
+                          ##### 12-Hour Mode Functions #####
+ ==================================================================================
+ */
+
+DS13072_Result_t
+DS13072_12Hour_ModeBits(const DS13072_DateTime_t *DateTime, uint8_t *HourReg)
+{
+  if (DateTime->Hour == 0 || DateTime->Hour > 12)
+    return DS13072_INVALID_PARAM;
+
+  *HourReg |= (1 << DS13072_HOUR_12H);
+  if (DateTime->isPM)
+    *HourReg |= (1 << DS13072_HOUR_PM);
+
+  return DS13072_OK;
+}
+
+
+DS13072_Result_t
+DS13072_12Hour_To24(const DS13072_DateTime_t *DateTime, uint8_t *Hour)
+{
+  if (DateTime->Hour == 0 || DateTime->Hour > 12)
+    return DS13072_INVALID_PARAM;
+
+  *Hour = DateTime->Hour % 12;
+  if (DateTime->isPM)
+    *Hour += 12;
+
+  return DS13072_OK;
+}
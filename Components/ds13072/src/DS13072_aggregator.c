@@ -0,0 +1,245 @@
+/* Includes ---------------------------------------------------------------------*/
+#include <string.h>
+#include "DS13072_aggregator.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#if (DS13072_AGGREGATOR_MAX_MEMBERS < 1) || (DS13072_AGGREGATOR_MAX_MEMBERS > 8)
+#error "DS13072_AGGREGATOR_MAX_MEMBERS must be between 1 and 8"
+#endif
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+static uint32_t
+DS13072_Aggregator_Distance(uint32_t A, uint32_t B)
+{
+  return (A > B) ? (A - B) : (B - A);
+}
+
+static uint32_t
+DS13072_Aggregator_Median(uint32_t *Values, uint8_t Count)
+{
+  uint32_t Value;
+  uint8_t i, j;
+
+  // insertion sort; there are at most 8 values
+  for (i = 1; i < Count; i++)
+  {
+    Value = Values[i];
+    for (j = i; j > 0 && Values[j - 1] > Value; j--)
+      Values[j] = Values[j - 1];
+    Values[j] = Value;
+  }
+
+  return Values[(Count - 1) / 2];
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize an aggregator with no members.
+ * @note   GetMonotonicUs, ReadAll and the parameters are not changed.
+ * @param  Aggregator: Pointer to aggregator
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ */
+DS13072_Result_t
+DS13072_Aggregator_Init(DS13072_Aggregator_t *Aggregator)
+{
+  memset(Aggregator->Members, 0, sizeof(Aggregator->Members));
+  Aggregator->Count = 0;
+  atomic_init(&Aggregator->Round, 0);
+
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Add a chip to the aggregator.
+ * @param  Aggregator: Pointer to aggregator
+ * @param  Handler: Initialized handler of the chip
+ * @param  Index: Pointer to store the member index (bit in the result masks);
+ *                can be NULL
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: The aggregator is full.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_Aggregator_AddMember(DS13072_Aggregator_t *Aggregator,
+                             DS13072_Handler_t *Handler, uint8_t *Index)
+{
+  if (!Handler)
+    return DS13072_INVALID_PARAM;
+
+  if (Aggregator->Count >= DS13072_AGGREGATOR_MAX_MEMBERS)
+    return DS13072_FAIL;
+
+  memset(&Aggregator->Members[Aggregator->Count], 0,
+         sizeof(DS13072_AggregatorMember_t));
+  Aggregator->Members[Aggregator->Count].Handler = Handler;
+  if (Index)
+    *Index = Aggregator->Count;
+  Aggregator->Count++;
+
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Read the date and time of one member.
+ * @note   Called by ReadAll from the task of the member; only touches the
+ *         sample of that member.
+ * @param  Aggregator: Pointer to aggregator
+ * @param  Index: Member index
+ * @retval None
+ */
+void
+DS13072_Aggregator_ReadMember(DS13072_Aggregator_t *Aggregator, uint8_t Index)
+{
+  DS13072_AggregatorMember_t *Member = &Aggregator->Members[Index];
+  DS13072_DateTime_t DateTime;
+  DS13072_Result_t Result = DS13072_FAIL;
+  uint32_t Round = atomic_load(&Aggregator->Round);
+  uint64_t Start = 0;
+  uint64_t End = 0;
+
+  if (Aggregator->GetMonotonicUs(&Start) == 0 &&
+      DS13072_GetDateTime(Member->Handler, &DateTime) == DS13072_OK &&
+      Aggregator->GetMonotonicUs(&End) == 0)
+  {
+    Result = DS13072_DateTimeToUnix(&DateTime, &Member->UnixTime);
+  }
+
+  Member->TimeUs = Start + (End - Start) / 2;
+  Member->Result = Result;
+  Member->Round = Round;
+}
+
+
+/**
+ * @brief  Read all chips concurrently and vote.
+ * @note   The result is the median of the chips that answered in time with a
+ *         valid, advancing date and time. Chips within ToleranceS of the
+ *         median agree; the others are outliers. Only one task may call this
+ *         function at a time.
+ * @param  Aggregator: Pointer to aggregator
+ * @param  Result: Pointer to store the result; the masks are set also when
+ *                 DS13072_FAIL is returned
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: No chip gave a usable date and time.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_Aggregator_Read(DS13072_Aggregator_t *Aggregator,
+                        DS13072_AggregatorResult_t *Result)
+{
+  DS13072_AggregatorMember_t *Member;
+  uint32_t Values[DS13072_AGGREGATOR_MAX_MEMBERS];
+  uint32_t TimeoutMs, ToleranceS;
+  uint64_t StuckUs;
+  uint64_t Start = 0;
+  uint64_t End = 0;
+  uint32_t Round;
+  uint32_t Done;
+  uint8_t Usable = 0;
+  uint8_t Agree = 0;
+  uint8_t i;
+
+  if (!Aggregator->Count ||
+      !Aggregator->GetMonotonicUs ||
+      !Aggregator->ReadAll)
+    return DS13072_INVALID_PARAM;
+
+  TimeoutMs = Aggregator->TimeoutMs ?
+              Aggregator->TimeoutMs : DS13072_AGGREGATOR_TIMEOUT_MS;
+  ToleranceS = Aggregator->ToleranceS ?
+               Aggregator->ToleranceS : DS13072_AGGREGATOR_TOLERANCE_S;
+  StuckUs = (uint64_t)(Aggregator->StuckMs ?
+                       Aggregator->StuckMs : DS13072_AGGREGATOR_STUCK_MS) * 1000;
+
+  // samples are tagged with the round; 0 marks a member never read
+  Round = (uint32_t)atomic_load(&Aggregator->Round) + 1;
+  if (Round == 0)
+    Round = 1;
+  atomic_store(&Aggregator->Round, Round);
+
+  Aggregator->GetMonotonicUs(&Start);
+  Done = Aggregator->ReadAll(Aggregator, TimeoutMs);
+  Aggregator->GetMonotonicUs(&End);
+
+  memset(Result, 0, sizeof(*Result));
+  Result->LatencyUs = (uint32_t)(End - Start);
+
+  for (i = 0; i < Aggregator->Count; i++)
+  {
+    Member = &Aggregator->Members[i];
+    if (!(Done & (1UL << i)) ||
+        Member->Round != Round ||
+        Member->Result != DS13072_OK)
+    {
+      Result->FailedMask |= 1 << i;
+      continue;
+    }
+
+    if (!Member->HasLast || Member->UnixTime != Member->LastUnixTime)
+    {
+      Member->LastUnixTime = Member->UnixTime;
+      Member->LastChangeUs = Member->TimeUs;
+      Member->HasLast = 1;
+    }
+    else if (Member->TimeUs - Member->LastChangeUs >= StuckUs)
+    {
+      Result->StuckMask |= 1 << i;
+      continue;
+    }
+
+    Values[Usable++] = Member->UnixTime;
+  }
+
+  if (!Usable)
+  {
+    Result->Confidence = DS13072_Confidence_None;
+    return DS13072_FAIL;
+  }
+
+  Result->UnixTime = DS13072_Aggregator_Median(Values, Usable);
+
+  for (i = 0; i < Aggregator->Count; i++)
+  {
+    if ((Result->FailedMask | Result->StuckMask) & (1 << i))
+      continue;
+
+    if (DS13072_Aggregator_Distance(Aggregator->Members[i].UnixTime,
+                                    Result->UnixTime) <= ToleranceS)
+    {
+      Result->AgreeMask |= 1 << i;
+      Agree++;
+    }
+  }
+
+  if (Agree == Aggregator->Count)
+    Result->Confidence = DS13072_Confidence_All;
+  else if (2 * Agree > Aggregator->Count)
+    Result->Confidence = DS13072_Confidence_Majority;
+  else
+    Result->Confidence = DS13072_Confidence_None;
+
+  if (DS13072_UnixToDateTime(Result->UnixTime, &Result->DateTime) != DS13072_OK)
+    return DS13072_FAIL;
+
+  return DS13072_OK;
+}
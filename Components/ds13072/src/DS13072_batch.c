@@ -0,0 +1,403 @@
+/* Includes ---------------------------------------------------------------------*/
+#include <string.h>
+#include "DS13072_batch.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+/**
+ * @brief  Records are converted in blocks of one bitmap word. Each block is
+ *         first copied field by field into local arrays; the conversion loops
+ *         then work on those arrays only, are branch-free and take restrict
+ *         pointers, so that the compiler can vectorize them.
+ */
+#define DS13072_BATCH_BLOCK      32
+
+/**
+ * @brief  Days from 1970-01-01 to 1996-03-01. Dates are counted in March-based
+ *         years from there, which puts every leap day at the end of a year and
+ *         makes every 4th year leap for the whole 2000 to 2099 range.
+ */
+#define DS13072_DAYS_TO_1996_03  9556U
+
+/**
+ * @brief  Month lengths minus 28, two bits per month (1 to 12)
+ */
+#define DS13072_MONTH_LEN_BITS   0x3BBEECCU
+
+
+/* Private Macro ----------------------------------------------------------------*/
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Convert 24-hour date and time fields to Unix time and check them.
+ * @note   32-bit arithmetic only; the range ends before 2106.
+ */
+static inline uint32_t
+DS13072_Batch_Encode(uint32_t Year, uint32_t Month, uint32_t Day,
+                     uint32_t Hour, uint32_t Minute, uint32_t Second,
+                     uint32_t *Ok)
+{
+  uint32_t Feb = (Month <= 2);
+  uint32_t Y = Year + 4 - Feb;          // March-based years since 1996
+  uint32_t Mp = Month - 3 + 12 * Feb;   // March = 0
+  uint32_t MonthLen = 28 +
+                      ((DS13072_MONTH_LEN_BITS >> ((Month & 0x0F) * 2)) & 3) +
+                      ((Month == 2) & ((Year & 3) == 0));
+  uint32_t Days;
+
+  *Ok = (Second < 60) & (Minute < 60) & (Hour < 24) &
+        ((Month - 1) < 12) & ((Day - 1) < MonthLen) & (Year < 100);
+
+  Days = DS13072_DAYS_TO_1996_03 + Y * 365 + Y / 4 +
+         (153 * Mp + 2) / 5 + Day - 1;
+
+  return Days * 86400U + Hour * 3600 + Minute * 60 + Second;
+}
+
+/**
+ * @brief  Decode one BCD field of a block in place. Ok is cleared for the
+ *         records with a digit out of range.
+ */
+static inline void
+DS13072_Batch_BCDBlock(uint8_t *restrict Value, uint8_t *restrict Ok,
+                       uint32_t Len)
+{
+  uint32_t i;
+
+  for (i = 0; i < Len; i++)
+  {
+    uint32_t BCD = Value[i];
+
+    Ok[i] &= ((BCD & 0x0F) < 10) & ((BCD >> 4) < 10);
+    Value[i] = (BCD >> 4) * 10 + (BCD & 0x0F);
+  }
+}
+
+/**
+ * @brief  Convert the 12-hour records of a block to 24-hour in place. Mode12
+ *         and PM are 0 or 1. Ok is cleared for 12-hour values outside 1 to 12,
+ *         and for every 12-hour record when DS13072_USE_12HOUR is 0, as in
+ *         DS13072_DateTimeToUnix.
+ */
+static inline void
+DS13072_Batch_Hour12Block(uint8_t *restrict Hour,
+                          const uint8_t *restrict Mode12,
+                          const uint8_t *restrict PM,
+                          uint8_t *restrict Ok, uint32_t Len)
+{
+  uint32_t i;
+
+  for (i = 0; i < Len; i++)
+  {
+    uint32_t H = Hour[i];
+    uint32_t H24 = (H == 12 ? 0 : H) + 12 * PM[i];
+
+#if DS13072_USE_12HOUR
+    Ok[i] &= (Mode12[i] == 0) | ((H - 1) < 12);
+#else
+    Ok[i] &= (Mode12[i] == 0);
+#endif
+    Hour[i] = Mode12[i] ? H24 : H;
+  }
+}
+
+/**
+ * @brief  Convert the 24-hour fields of a block to Unix time. Ok is cleared
+ *         for the records whose date and time do not exist.
+ */
+static inline void
+DS13072_Batch_EncodeBlock(const uint8_t *restrict Year,
+                          const uint8_t *restrict Month,
+                          const uint8_t *restrict Day,
+                          const uint8_t *restrict Hour,
+                          const uint8_t *restrict Minute,
+                          const uint8_t *restrict Second,
+                          uint32_t *restrict UnixTime,
+                          uint8_t *restrict Ok, uint32_t Len)
+{
+  uint32_t DateOk;
+  uint32_t i;
+
+  for (i = 0; i < Len; i++)
+  {
+    UnixTime[i] = DS13072_Batch_Encode(Year[i], Month[i], Day[i],
+                                       Hour[i], Minute[i], Second[i],
+                                       &DateOk);
+    Ok[i] &= DateOk;
+  }
+}
+
+/**
+ * @brief  Convert the Unix times of a block to 24-hour fields. Ok is set for
+ *         the records within 2000 to 2099.
+ */
+static inline void
+DS13072_Batch_DecodeBlock(const uint32_t *restrict UnixTime,
+                          uint8_t *restrict Second, uint8_t *restrict Minute,
+                          uint8_t *restrict Hour, uint8_t *restrict WeekDay,
+                          uint8_t *restrict Day, uint8_t *restrict Month,
+                          uint8_t *restrict Year, uint8_t *restrict Ok,
+                          uint32_t Len)
+{
+  uint32_t i;
+
+  for (i = 0; i < Len; i++)
+  {
+    uint32_t InRange = (UnixTime[i] - DS13072_UNIX_2000) <
+                       (DS13072_UNIX_2100 - DS13072_UNIX_2000);
+    uint32_t Time = InRange ? UnixTime[i] : DS13072_UNIX_2000;
+    uint32_t Days = Time / 86400;
+    uint32_t Secs = Time - Days * 86400;
+    uint32_t z = Days - DS13072_DAYS_TO_1996_03;
+    uint32_t Cycle = z / 1461;
+    uint32_t r = z - Cycle * 1461;
+    uint32_t YearOfCycle = (r - r / 1460) / 365;
+    uint32_t DayOfYear = r - YearOfCycle * 365;
+    uint32_t Mp = (5 * DayOfYear + 2) / 153;
+    uint32_t Mon = Mp < 10 ? Mp + 3 : Mp - 9;
+    uint32_t Mins = Secs / 60;
+
+    Second[i]  = Secs - Mins * 60;
+    Minute[i]  = Mins % 60;
+    Hour[i]    = Secs / 3600;
+    WeekDay[i] = (Days + 3) % 7 + 1;
+    Day[i]     = DayOfYear - (153 * Mp + 2) / 5 + 1;
+    Month[i]   = Mon;
+    Year[i]    = Cycle * 4 + YearOfCycle + (Mon <= 2) - 4;
+    Ok[i]      = InRange;
+  }
+}
+
+/**
+ * @brief  Pack per-record validity flags (0 or 1) into one bitmap word.
+ */
+static uint32_t
+DS13072_Batch_PackMask(const uint8_t *Ok, uint32_t Count, uint32_t *Word)
+{
+  uint32_t Mask = 0;
+  uint32_t Valid = 0;
+  uint32_t i;
+
+  for (i = 0; i < Count; i++)
+  {
+    Mask |= (uint32_t)Ok[i] << i;
+    Valid += Ok[i];
+  }
+
+  *Word = Mask;
+  return Valid;
+}
+
+
+
+/**
+ ==================================================================================
+                     ##### Public Batch Conversion Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Convert raw register snapshots to Unix time.
+ * @note   Each snapshot is the 7-byte burst read from the SECOND register
+ *         onwards, decoded the same way as DS13072_RegsToDateTime.
+ * @note   A record is invalid if a BCD digit is out of range or the date and
+ *         time do not exist, or if it is in 12-hour mode and
+ *         DS13072_USE_12HOUR is 0; its UnixTime is undefined.
+ * @param  Regs: Array of register snapshots
+ * @param  UnixTime: Array to store the results (seconds since 1970)
+ * @param  Valid: Validity bitmap, DS13072_BATCH_BITMAP_WORDS(Count) words
+ * @param  Count: Number of records
+ * @retval Number of valid records
+ */
+uint32_t
+DS13072_Batch_RegsToUnix(const uint8_t (*Regs)[7], uint32_t *UnixTime,
+                         uint32_t *Valid, uint32_t Count)
+{
+  uint8_t Second[DS13072_BATCH_BLOCK];
+  uint8_t Minute[DS13072_BATCH_BLOCK];
+  uint8_t Hour[DS13072_BATCH_BLOCK];
+  uint8_t Day[DS13072_BATCH_BLOCK];
+  uint8_t Month[DS13072_BATCH_BLOCK];
+  uint8_t Year[DS13072_BATCH_BLOCK];
+  uint8_t Mode12[DS13072_BATCH_BLOCK];
+  uint8_t PM[DS13072_BATCH_BLOCK];
+  uint8_t Ok[DS13072_BATCH_BLOCK];
+  uint32_t Total = 0;
+  uint32_t Base;
+  uint32_t Len;
+  uint32_t i;
+
+  for (Base = 0; Base < Count; Base += DS13072_BATCH_BLOCK)
+  {
+    const uint8_t (*Block)[7] = Regs + Base;
+
+    Len = MIN(Count - Base, DS13072_BATCH_BLOCK);
+    for (i = 0; i < Len; i++)
+    {
+      uint8_t HourReg = Block[i][2];
+
+      Mode12[i] = (HourReg >> DS13072_HOUR_12H) & 1;
+      PM[i]     = (HourReg >> DS13072_HOUR_PM) & 1;
+      Second[i] = Block[i][0] & 0x7F;
+      Minute[i] = Block[i][1];
+      Hour[i]   = HourReg & (Mode12[i] ? 0x1F : 0x3F);
+      Day[i]    = Block[i][4];
+      Month[i]  = Block[i][5];
+      Year[i]   = Block[i][6];
+      Ok[i]     = 1;
+    }
+
+    DS13072_Batch_BCDBlock(Second, Ok, Len);
+    DS13072_Batch_BCDBlock(Minute, Ok, Len);
+    DS13072_Batch_BCDBlock(Hour, Ok, Len);
+    DS13072_Batch_BCDBlock(Day, Ok, Len);
+    DS13072_Batch_BCDBlock(Month, Ok, Len);
+    DS13072_Batch_BCDBlock(Year, Ok, Len);
+    DS13072_Batch_Hour12Block(Hour, Mode12, PM, Ok, Len);
+    DS13072_Batch_EncodeBlock(Year, Month, Day, Hour, Minute, Second,
+                              UnixTime + Base, Ok, Len);
+
+    Total += DS13072_Batch_PackMask(Ok, Len, &Valid[Base / 32]);
+  }
+
+  return Total;
+}
+
+
+/**
+ * @brief  Convert date and time structures to Unix time.
+ * @note   Same rules as DS13072_DateTimeToUnix; invalid records get their
+ *         bit cleared instead of stopping the conversion.
+ * @param  DateTime: Array of date and time value structures
+ * @param  UnixTime: Array to store the results (seconds since 1970)
+ * @param  Valid: Validity bitmap, DS13072_BATCH_BITMAP_WORDS(Count) words
+ * @param  Count: Number of records
+ * @retval Number of valid records
+ */
+uint32_t
+DS13072_Batch_DateTimeToUnix(const DS13072_DateTime_t *DateTime,
+                             uint32_t *UnixTime, uint32_t *Valid,
+                             uint32_t Count)
+{
+  uint8_t Second[DS13072_BATCH_BLOCK];
+  uint8_t Minute[DS13072_BATCH_BLOCK];
+  uint8_t Hour[DS13072_BATCH_BLOCK];
+  uint8_t Day[DS13072_BATCH_BLOCK];
+  uint8_t Month[DS13072_BATCH_BLOCK];
+  uint8_t Year[DS13072_BATCH_BLOCK];
+  uint8_t Mode12[DS13072_BATCH_BLOCK];
+  uint8_t PM[DS13072_BATCH_BLOCK];
+  uint8_t Ok[DS13072_BATCH_BLOCK];
+  uint32_t Total = 0;
+  uint32_t Base;
+  uint32_t Len;
+  uint32_t i;
+
+  for (Base = 0; Base < Count; Base += DS13072_BATCH_BLOCK)
+  {
+    const DS13072_DateTime_t *Block = DateTime + Base;
+
+    Len = MIN(Count - Base, DS13072_BATCH_BLOCK);
+    for (i = 0; i < Len; i++)
+    {
+      Second[i] = Block[i].Second;
+      Minute[i] = Block[i].Minute;
+      Hour[i]   = Block[i].Hour;
+      Day[i]    = Block[i].Day;
+      Month[i]  = Block[i].Month;
+      Year[i]   = Block[i].Year;
+      Mode12[i] = (Block[i].HourMode == 1);
+      PM[i]     = (Block[i].isPM != 0);
+      Ok[i]     = 1;
+    }
+
+    DS13072_Batch_Hour12Block(Hour, Mode12, PM, Ok, Len);
+    DS13072_Batch_EncodeBlock(Year, Month, Day, Hour, Minute, Second,
+                              UnixTime + Base, Ok, Len);
+
+    Total += DS13072_Batch_PackMask(Ok, Len, &Valid[Base / 32]);
+  }
+
+  return Total;
+}
+
+
+/**
+ * @brief  Convert date and time arrays to Unix time.
+ * @note   WeekDay is not used and may be NULL. UnixTime must not overlap the
+ *         input arrays.
+ * @param  Arrays: Date and time records in structure-of-arrays layout
+ * @param  UnixTime: Array to store the results (seconds since 1970)
+ * @param  Valid: Validity bitmap, DS13072_BATCH_BITMAP_WORDS(Count) words
+ * @param  Count: Number of records
+ * @retval Number of valid records
+ */
+uint32_t
+DS13072_Batch_ArraysToUnix(const DS13072_DateTimeArrays_t *Arrays,
+                           uint32_t *UnixTime, uint32_t *Valid,
+                           uint32_t Count)
+{
+  uint8_t Ok[DS13072_BATCH_BLOCK];
+  uint32_t Total = 0;
+  uint32_t Base;
+  uint32_t Len;
+
+  for (Base = 0; Base < Count; Base += DS13072_BATCH_BLOCK)
+  {
+    Len = MIN(Count - Base, DS13072_BATCH_BLOCK);
+    memset(Ok, 1, Len);
+    DS13072_Batch_EncodeBlock(Arrays->Year + Base, Arrays->Month + Base,
+                              Arrays->Day + Base, Arrays->Hour + Base,
+                              Arrays->Minute + Base, Arrays->Second + Base,
+                              UnixTime + Base, Ok, Len);
+
+    Total += DS13072_Batch_PackMask(Ok, Len, &Valid[Base / 32]);
+  }
+
+  return Total;
+}
+
+
+/**
+ * @brief  Convert Unix time to date and time arrays.
+ * @note   Records outside 2000 to 2099 are invalid; their fields are
+ *         undefined. The arrays must not overlap.
+ * @param  UnixTime: Array of Unix times (seconds since 1970)
+ * @param  Arrays: Date and time records in structure-of-arrays layout
+ * @param  Valid: Validity bitmap, DS13072_BATCH_BITMAP_WORDS(Count) words
+ * @param  Count: Number of records
+ * @retval Number of valid records
+ */
+uint32_t
+DS13072_Batch_UnixToArrays(const uint32_t *UnixTime,
+                           const DS13072_DateTimeArrays_t *Arrays,
+                           uint32_t *Valid, uint32_t Count)
+{
+  uint8_t Ok[DS13072_BATCH_BLOCK];
+  uint32_t Total = 0;
+  uint32_t Base;
+  uint32_t Len;
+
+  for (Base = 0; Base < Count; Base += DS13072_BATCH_BLOCK)
+  {
+    Len = MIN(Count - Base, DS13072_BATCH_BLOCK);
+    DS13072_Batch_DecodeBlock(UnixTime + Base,
+                              Arrays->Second + Base, Arrays->Minute + Base,
+                              Arrays->Hour + Base, Arrays->WeekDay + Base,
+                              Arrays->Day + Base, Arrays->Month + Base,
+                              Arrays->Year + Base, Ok, Len);
+
+    Total += DS13072_Batch_PackMask(Ok, Len, &Valid[Base / 32]);
+  }
+
+  return Total;
+}
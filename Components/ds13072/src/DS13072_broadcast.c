@@ -0,0 +1,296 @@
+/* Includes ---------------------------------------------------------------------*/
+#include <string.h>
+#include "DS13072_broadcast.h"
+#include "DS13072_private.h"
+
+
+/* Private Macro ----------------------------------------------------------------*/
+#define DS13072_BROADCAST_RING_MASK  (DS13072_BROADCAST_RING_SIZE - 1)
+
+// subscriber handles copied from the table at a time, to keep both the
+// publisher stack and the critical sections short
+#define DS13072_BROADCAST_NOTIFY_CHUNK  16
+
+#if (DS13072_BROADCAST_RING_SIZE < 2) || \
+    (DS13072_BROADCAST_RING_SIZE & DS13072_BROADCAST_RING_MASK)
+#error "DS13072_BROADCAST_RING_SIZE must be a power of 2 and at least 2"
+#endif
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+static void
+DS13072_Broadcast_Publish(DS13072_Broadcast_t *Broadcast,
+                          const DS13072_DateTime_t *DateTime)
+{
+  TaskHandle_t Subscribers[DS13072_BROADCAST_NOTIFY_CHUNK];
+  uint32_t Next;
+  uint16_t Slot;
+  uint8_t Count;
+  uint8_t i;
+
+  // single writer: fill the slot after the published one, then publish it
+  Next = atomic_load_explicit(&Broadcast->Sequence, memory_order_relaxed) + 1;
+  if (Next == 0)
+    Next = 1;
+  Broadcast->Ring[Next & DS13072_BROADCAST_RING_MASK] = *DateTime;
+  atomic_store_explicit(&Broadcast->Sequence, Next, memory_order_release);
+
+  // the notifications are sent outside the lock, a chunk of the table at a
+  // time
+  for (Slot = 0; Slot < DS13072_BROADCAST_MAX_SUBSCRIBERS; Slot += Count)
+  {
+    Count = MIN(DS13072_BROADCAST_NOTIFY_CHUNK,
+                DS13072_BROADCAST_MAX_SUBSCRIBERS - Slot);
+
+    taskENTER_CRITICAL(&Broadcast->Lock);
+    memcpy(Subscribers, &Broadcast->Subscribers[Slot],
+           Count * sizeof(Subscribers[0]));
+    taskEXIT_CRITICAL(&Broadcast->Lock);
+
+    for (i = 0; i < Count; i++)
+    {
+      if (Subscribers[i])
+        xTaskNotifyGiveIndexed(Subscribers[i], DS13072_BROADCAST_NOTIFY_INDEX);
+    }
+  }
+}
+
+
+static void
+DS13072_Broadcast_Task(void *Param)
+{
+  DS13072_Broadcast_t *Broadcast = (DS13072_Broadcast_t *)Param;
+  const TickType_t OneSecond = pdMS_TO_TICKS(1000);
+  DS13072_DateTime_t DateTime;
+  uint8_t LastSecond = 0xFF;
+  uint8_t Second;
+  TickType_t Seen = 0;  // time of the last read that returned LastSecond
+  TickType_t Step = 1;
+  TickType_t Now;
+  TickType_t Lo;
+
+  while (Broadcast->Running)
+  {
+    Now = xTaskGetTickCount();
+    if (DS13072_GetSecond(Broadcast->Handler, &Second) != DS13072_OK)
+    {
+      LastSecond = 0xFF;
+      vTaskDelay(OneSecond);
+      continue;
+    }
+
+    if (Second == LastSecond)
+    {
+      // still before the edge: poll the seconds register again
+      Seen = Now;
+      vTaskDelay(Step);
+      continue;
+    }
+
+    // the edge is after the last read of the old second and at most one
+    // second before this read; the first read after start is not on an edge,
+    // it is published anyway and the search starts from there
+    Lo = (LastSecond != 0xFF && (TickType_t)(Now - Seen) < OneSecond) ?
+         Seen : Now - OneSecond;
+
+    if (DS13072_GetDateTime(Broadcast->Handler, &DateTime) != DS13072_OK)
+    {
+      LastSecond = 0xFF;
+      vTaskDelay(OneSecond);
+      continue;
+    }
+
+    LastSecond = DateTime.Second;
+    Seen = Now;
+    DS13072_Broadcast_Publish(Broadcast, &DateTime);
+
+    // the next edge is one second after (Lo, Now]: wake up the guard before
+    // it and poll at an eighth of that window, down to every tick
+    Step = (Now - Lo) / 8;
+    if (!Step)
+      Step = 1;
+    vTaskDelayUntil(&Lo, OneSecond - DS13072_BROADCAST_GUARD_TICKS);
+  }
+
+  Broadcast->Task = NULL;
+  vTaskDelete(NULL);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Start the publisher task.
+ * @note   The task finds the rollover of the seconds register with 1-byte
+ *         reads, then reads the date and time once and publishes it to all
+ *         readers. Once the edge is tracked this takes about
+ *         DS13072_BROADCAST_GUARD_TICKS + 2 short reads and one date and time
+ *         read per second. No other task should read the date and time from
+ *         the chip.
+ * @param  Broadcast: Pointer to broadcast handler
+ * @param  Priority: FreeRTOS priority of the publisher task
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to create the task.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_Broadcast_Start(DS13072_Broadcast_t *Broadcast, UBaseType_t Priority)
+{
+  uint8_t i;
+
+  if (!Broadcast->Handler || Broadcast->Task)
+    return DS13072_INVALID_PARAM;
+
+  atomic_init(&Broadcast->Sequence, 0);
+  memset(Broadcast->Subscribers, 0, sizeof(Broadcast->Subscribers));
+  for (i = 0; i < DS13072_BROADCAST_MAX_SUBSCRIBERS; i++)
+    Broadcast->FreeSlots[i] = DS13072_BROADCAST_MAX_SUBSCRIBERS - 1 - i;
+  Broadcast->FreeCount = DS13072_BROADCAST_MAX_SUBSCRIBERS;
+  portMUX_INITIALIZE(&Broadcast->Lock);
+
+  Broadcast->Running = 1;
+  if (xTaskCreate(DS13072_Broadcast_Task, "ds13072_bcast",
+                  DS13072_BROADCAST_STACK_SIZE, Broadcast, Priority,
+                  &Broadcast->Task) != pdPASS)
+  {
+    Broadcast->Running = 0;
+    Broadcast->Task = NULL;
+    return DS13072_FAIL;
+  }
+
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Stop the publisher task.
+ * @note   Returns after the task has exited. DS13072_Broadcast_Start clears
+ *         all subscriptions.
+ * @param  Broadcast: Pointer to broadcast handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ */
+DS13072_Result_t
+DS13072_Broadcast_Stop(DS13072_Broadcast_t *Broadcast)
+{
+  Broadcast->Running = 0;
+  while (Broadcast->Task)
+    vTaskDelay(1);
+
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Register a task to be notified on every published second.
+ * @note   The task is signalled with xTaskNotifyGiveIndexed on
+ *         DS13072_BROADCAST_NOTIFY_INDEX; it should wait with
+ *         ulTaskNotifyTakeIndexed and then call DS13072_Broadcast_Read.
+ * @param  Broadcast: Pointer to broadcast handler
+ * @param  Task: Task to notify
+ * @param  Id: Pointer to store the subscription id
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: All subscriber slots are in use.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_Broadcast_Subscribe(DS13072_Broadcast_t *Broadcast,
+                            TaskHandle_t Task, uint8_t *Id)
+{
+  DS13072_Result_t Result = DS13072_FAIL;
+
+  if (!Task)
+    return DS13072_INVALID_PARAM;
+
+  taskENTER_CRITICAL(&Broadcast->Lock);
+  if (Broadcast->FreeCount)
+  {
+    *Id = Broadcast->FreeSlots[--Broadcast->FreeCount];
+    Broadcast->Subscribers[*Id] = Task;
+    Result = DS13072_OK;
+  }
+  taskEXIT_CRITICAL(&Broadcast->Lock);
+
+  return Result;
+}
+
+
+/**
+ * @brief  Remove a task registered by DS13072_Broadcast_Subscribe.
+ * @note   A notification of a second being published can still reach the
+ *         task just after this returns.
+ * @param  Broadcast: Pointer to broadcast handler
+ * @param  Id: Subscription id
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: Id is not subscribed.
+ */
+DS13072_Result_t
+DS13072_Broadcast_Unsubscribe(DS13072_Broadcast_t *Broadcast, uint8_t Id)
+{
+  DS13072_Result_t Result = DS13072_INVALID_PARAM;
+
+  if (Id >= DS13072_BROADCAST_MAX_SUBSCRIBERS)
+    return DS13072_INVALID_PARAM;
+
+  taskENTER_CRITICAL(&Broadcast->Lock);
+  if (Broadcast->Subscribers[Id])
+  {
+    Broadcast->Subscribers[Id] = NULL;
+    Broadcast->FreeSlots[Broadcast->FreeCount++] = Id;
+    Result = DS13072_OK;
+  }
+  taskEXIT_CRITICAL(&Broadcast->Lock);
+
+  return Result;
+}
+
+
+/**
+ * @brief  Get the last published date and time without bus traffic.
+ * @note   Lock-free; can be called from any task at any rate.
+ * @param  Broadcast: Pointer to broadcast handler
+ * @param  DateTime: pointer to date and time value structure
+ * @param  Sequence: Pointer to store the sample sequence number, which
+ *         increases by one per published second (can be NULL)
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Nothing has been published yet.
+ */
+DS13072_Result_t
+DS13072_Broadcast_Read(DS13072_Broadcast_t *Broadcast,
+                       DS13072_DateTime_t *DateTime, uint32_t *Sequence)
+{
+  uint32_t Seq;
+
+  do
+  {
+    Seq = atomic_load_explicit(&Broadcast->Sequence, memory_order_acquire);
+    if (Seq == 0)
+      return DS13072_FAIL;
+
+    *DateTime = Broadcast->Ring[Seq & DS13072_BROADCAST_RING_MASK];
+    atomic_thread_fence(memory_order_acquire);
+
+    // the copy is valid unless the writer has wrapped around onto our slot
+  } while ((uint32_t)(atomic_load_explicit(&Broadcast->Sequence,
+                                           memory_order_relaxed) - Seq) >=
+           DS13072_BROADCAST_RING_SIZE - 1);
+
+  if (Sequence)
+    *Sequence = Seq;
+
+  return DS13072_OK;
+}
@@ -0,0 +1,71 @@
+/* Includes ---------------------------------------------------------------------*/
+#include "DS13072_private.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+/**
+ * @brief  Non-volatile RAM Address
+ */ 
+#define DS13072_RAM      0x08  // the address of first byte of Non-volatile RAM
+#define DS13072_RAM_SIZE 56    // size of Non-volatile
+
+
+
+/**
+ ==================================================================================
+                       ##### Public Memory Functions #####                         
+ ==================================================================================
+ */
+
+/**
+ * @brief  Write data on DS13072 data Non-volatile RAM
+ * @param  Handler: Pointer to handler
+ * @param  Address: address of block beginning (0 to 55)
+ * @param  Data: pointer to data array
+ * @param  Size: data size (1 to 56)
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data.
+ *         - DS13072_INVALID_PARAM: Requested area is out of range.
+ */
+DS13072_Result_t
+DS13072_WriteRAM(DS13072_Handler_t *Handler,
+                uint8_t Address, uint8_t *Data, uint8_t Size)
+{
+  Address += 8;
+
+  if ((Address + Size) > (DS13072_RAM + DS13072_RAM_SIZE))
+    return DS13072_INVALID_PARAM;
+
+  if (DS13072_WriteRegs(Handler, Address, Data, Size) < 0)
+    return DS13072_FAIL;
+
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Read data from DS13072 data Non-volatile RAM
+ * @param  Handler: Pointer to handler
+ * @param  Address: address of block beginning (0 to 55)
+ * @param  Data: pointer to data array
+ * @param  Size: data size (1 to 56)
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data.
+ *         - DS13072_INVALID_PARAM: Requested area is out of range.
+ */
+DS13072_Result_t
+DS13072_ReadRAM(DS13072_Handler_t *Handler,
+               uint8_t Address, uint8_t *Data, uint8_t Size)
+{
+  Address += 8;
+
+  if ((Address + Size) > (DS13072_RAM + DS13072_RAM_SIZE))
+    return DS13072_INVALID_PARAM;
+
+  if (DS13072_ReadRegs(Handler, Address, Data, Size) < 0)
+    return DS13072_FAIL;
+
+  return DS13072_OK;
+}
@@ -0,0 +1,244 @@
+/* Includes ---------------------------------------------------------------------*/
+#include "DS13072_packed.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#if DS13072_USE_EVENTLOG
+/**
+ * @brief  Event log layout in the Non-volatile RAM
+ */
+#define DS13072_EVENTLOG_MAGIC      0xE7
+#define DS13072_EVENTLOG_HEADER     4     // Magic, Capacity, Head, Count
+#define DS13072_EVENTLOG_ENTRY      4     // little-endian DS13072_Packed_t
+#define DS13072_EVENTLOG_SIZE       (DS13072_EVENTLOG_HEADER + \
+                                     DS13072_EVENTLOG_CAPACITY * \
+                                     DS13072_EVENTLOG_ENTRY)
+
+#if (DS13072_EVENTLOG_CAPACITY < 1) || \
+    (DS13072_EVENTLOG_ADDRESS + DS13072_EVENTLOG_SIZE > 56)
+#error "DS13072 event log does not fit in the Non-volatile RAM"
+#endif
+#endif
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+#if DS13072_USE_EVENTLOG
+static DS13072_Result_t
+DS13072_EventLog_ReadHeader(DS13072_Handler_t *Handler, uint8_t *Header)
+{
+  if (DS13072_ReadRAM(Handler, DS13072_EVENTLOG_ADDRESS,
+                      Header, DS13072_EVENTLOG_HEADER) != DS13072_OK)
+    return DS13072_FAIL;
+
+  if (Header[0] != DS13072_EVENTLOG_MAGIC ||
+      Header[1] != DS13072_EVENTLOG_CAPACITY ||
+      Header[2] >= DS13072_EVENTLOG_CAPACITY ||
+      Header[3] > DS13072_EVENTLOG_CAPACITY)
+    return DS13072_INVALID_PARAM;
+
+  return DS13072_OK;
+}
+#endif
+
+
+
+/**
+ ==================================================================================
+                       ##### Public Packed Time Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Pack date and time into 32 bits
+ * @param  DateTime: pointer to date and time value structure
+ * @param  Packed: pointer to store the result
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_Pack(const DS13072_DateTime_t *DateTime, DS13072_Packed_t *Packed)
+{
+  uint32_t UnixTime;
+
+  if (DS13072_DateTimeToUnix(DateTime, &UnixTime) != DS13072_OK)
+    return DS13072_INVALID_PARAM;
+
+  *Packed = UnixTime - DS13072_PACKED_EPOCH;
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Pack a raw register snapshot into 32 bits
+ * @param  Regs: 7-byte burst read from the SECOND register onwards
+ * @param  Packed: pointer to store the result
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: Registers do not hold a valid date and time.
+ */
+DS13072_Result_t
+DS13072_PackRegs(const uint8_t Regs[7], DS13072_Packed_t *Packed)
+{
+  DS13072_DateTime_t DateTime;
+
+  if (DS13072_RegsToDateTime(Regs, &DateTime) != DS13072_OK)
+    return DS13072_INVALID_PARAM;
+
+  return DS13072_Pack(&DateTime, Packed);
+}
+
+
+/**
+ * @brief  Unpack 32 bits into date and time in 24-hour mode
+ * @param  Packed: packed date and time
+ * @param  DateTime: pointer to date and time value structure
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: Packed is after 2099.
+ */
+DS13072_Result_t
+DS13072_Unpack(DS13072_Packed_t Packed, DS13072_DateTime_t *DateTime)
+{
+  if (Packed > 0xFFFFFFFFUL - DS13072_PACKED_EPOCH)
+    return DS13072_INVALID_PARAM;
+
+  return DS13072_UnixToDateTime(Packed + DS13072_PACKED_EPOCH, DateTime);
+}
+
+
+
+#if DS13072_USE_EVENTLOG
+/**
+ ==================================================================================
+                        ##### Public Event Log Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Prepare the event log in Non-volatile RAM
+ * @note   An existing log is kept. If the area does not hold a log with the
+ *         configured capacity (first use, or lost backup power), an empty
+ *         log is written.
+ * @param  Handler: Pointer to handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data.
+ */
+DS13072_Result_t
+DS13072_EventLog_Init(DS13072_Handler_t *Handler)
+{
+  uint8_t Header[DS13072_EVENTLOG_HEADER];
+  DS13072_Result_t Result;
+
+  Result = DS13072_EventLog_ReadHeader(Handler, Header);
+  if (Result != DS13072_INVALID_PARAM)
+    return Result;
+
+  Header[0] = DS13072_EVENTLOG_MAGIC;
+  Header[1] = DS13072_EVENTLOG_CAPACITY;
+  Header[2] = 0;
+  Header[3] = 0;
+  if (DS13072_WriteRAM(Handler, DS13072_EVENTLOG_ADDRESS,
+                       Header, DS13072_EVENTLOG_HEADER) != DS13072_OK)
+    return DS13072_FAIL;
+
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Add an event to the log
+ * @note   When the log is full the oldest event is overwritten.
+ * @param  Handler: Pointer to handler
+ * @param  Packed: packed date and time of the event
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data, or the log is not
+ *                         initialized.
+ */
+DS13072_Result_t
+DS13072_EventLog_Append(DS13072_Handler_t *Handler, DS13072_Packed_t Packed)
+{
+  uint8_t Header[DS13072_EVENTLOG_HEADER];
+  uint8_t Entry[DS13072_EVENTLOG_ENTRY];
+
+  if (DS13072_EventLog_ReadHeader(Handler, Header) != DS13072_OK)
+    return DS13072_FAIL;
+
+  Entry[0] = Packed;
+  Entry[1] = Packed >> 8;
+  Entry[2] = Packed >> 16;
+  Entry[3] = Packed >> 24;
+
+  // the entry goes first; if power fails before the header is updated, the
+  // log still reads as it was, except that a full log reads the new event
+  // in place of its oldest one
+  if (DS13072_WriteRAM(Handler, DS13072_EVENTLOG_ADDRESS +
+                       DS13072_EVENTLOG_HEADER +
+                       Header[2] * DS13072_EVENTLOG_ENTRY,
+                       Entry, DS13072_EVENTLOG_ENTRY) != DS13072_OK)
+    return DS13072_FAIL;
+
+  Header[2] = (Header[2] + 1) % DS13072_EVENTLOG_CAPACITY;
+  if (Header[3] < DS13072_EVENTLOG_CAPACITY)
+    Header[3]++;
+
+  if (DS13072_WriteRAM(Handler, DS13072_EVENTLOG_ADDRESS + 2,
+                       &Header[2], 2) != DS13072_OK)
+    return DS13072_FAIL;
+
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Read all events in the log, newest first
+ * @note   The whole log is read in one burst.
+ * @param  Handler: Pointer to handler
+ * @param  Events: Array of DS13072_EVENTLOG_CAPACITY elements
+ * @param  Count: Pointer to store the number of events read
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data, or the log is not
+ *                         initialized.
+ */
+DS13072_Result_t
+DS13072_EventLog_Read(DS13072_Handler_t *Handler,
+                      DS13072_Packed_t *Events, uint8_t *Count)
+{
+  uint8_t Buffer[DS13072_EVENTLOG_SIZE];
+  uint8_t *Entry;
+  uint8_t Index;
+  uint8_t i;
+
+  if (DS13072_ReadRAM(Handler, DS13072_EVENTLOG_ADDRESS,
+                      Buffer, sizeof(Buffer)) != DS13072_OK)
+    return DS13072_FAIL;
+
+  if (Buffer[0] != DS13072_EVENTLOG_MAGIC ||
+      Buffer[1] != DS13072_EVENTLOG_CAPACITY ||
+      Buffer[2] >= DS13072_EVENTLOG_CAPACITY ||
+      Buffer[3] > DS13072_EVENTLOG_CAPACITY)
+    return DS13072_FAIL;
+
+  Index = Buffer[2];
+  for (i = 0; i < Buffer[3]; i++)
+  {
+    Index = (Index + DS13072_EVENTLOG_CAPACITY - 1) % DS13072_EVENTLOG_CAPACITY;
+    Entry = &Buffer[DS13072_EVENTLOG_HEADER + Index * DS13072_EVENTLOG_ENTRY];
+    Events[i] = (uint32_t)Entry[0] |
+                ((uint32_t)Entry[1] << 8) |
+                ((uint32_t)Entry[2] << 16) |
+                ((uint32_t)Entry[3] << 24);
+  }
+
+  *Count = Buffer[3];
+  return DS13072_OK;
+}
+#endif
@@ -1,12 +1,50 @@
 /* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
 #include "DS13072_platform.h"
 #include "sdkconfig.h"
 #include "esp_system.h"
-#include "driver/i2c.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "driver/i2c.h"
+#include "driver/gpio.h"
+#include "soc/soc_caps.h"
 
 #define DS13072_ADDRESS 0x68 
 
+/**
+ * @brief  Number of I2C ports that can drive a DS13072 (low-power I2C
+ *         controllers are not used)
+ */
+#if defined(SOC_HP_I2C_NUM)
+#define DS13072_PLATFORM_PORTS  ((SOC_HP_I2C_NUM > 2) ? 2 : SOC_HP_I2C_NUM)
+#else
+#define DS13072_PLATFORM_PORTS  ((SOC_I2C_NUM > 2) ? 2 : SOC_I2C_NUM)
+#endif
+
+/**
+ * @brief  Platform functions and GPIOs of one I2C port
+ */
+typedef struct Platform_PortFunctions_s
+{
+  DS13072_PlatformInitDeinit_t  Init;
+  DS13072_PlatformInitDeinit_t  DeInit;
+  DS13072_PlatformSendReceive_t Send;
+  DS13072_PlatformSendReceive_t Receive;
+  DS13072_PlatformLock_t        Lock;
+  DS13072_PlatformLock_t        Unlock;
+} Platform_PortFunctions_t;
+
+typedef struct Platform_Port_s
+{
+  gpio_num_t        Sda;
+  gpio_num_t        Scl;
+  SemaphoreHandle_t Bus;  // held for one register access
+} Platform_Port_t;
+
+static Platform_Port_t Platform_Ports[DS13072_PLATFORM_PORTS];
+
+
+
 /**
  ==================================================================================
                            ##### Private Functions #####                           
@@ -14,53 +52,52 @@
  */
 
 static int8_t
-Platform_Init(void)
+Platform_PortInit(i2c_port_t Port)
 {
   i2c_config_t conf = {0};
 
   conf.mode = I2C_MODE_MASTER;
-  conf.sda_io_num = DS13072_SDA_GPIO;
+  conf.sda_io_num = Platform_Ports[Port].Sda;
   conf.sda_pullup_en = GPIO_PULLUP_ENABLE;
-  conf.scl_io_num = DS13072_SCL_GPIO;
+  conf.scl_io_num = Platform_Ports[Port].Scl;
   conf.scl_pullup_en = GPIO_PULLUP_ENABLE;
   conf.master.clk_speed = DS13072_I2C_RATE;
-  i2c_param_config(DS13072_I2C_NUM, &conf);
-  i2c_driver_install(DS13072_I2C_NUM, conf.mode,0, 0, 0);
+  i2c_param_config(Port, &conf);
+  i2c_driver_install(Port, conf.mode, 0, 0, 0);
 
   uint8_t addr = DS13072_ADDRESS << 1;
-  i2c_cmd_handle_t DS13072_i2c_cmd_handle  = i2c_cmd_link_create();
-  i2c_master_start(DS13072_i2c_cmd_handle); 
-  i2c_master_write(DS13072_i2c_cmd_handle, &addr ,1,1);
+  i2c_cmd_handle_t DS13072_i2c_cmd_handle = i2c_cmd_link_create();
+  i2c_master_start(DS13072_i2c_cmd_handle);
+  i2c_master_write(DS13072_i2c_cmd_handle, &addr, 1, 1);
   i2c_master_stop(DS13072_i2c_cmd_handle);
 
-      esp_err_t ret = i2c_master_cmd_begin(DS13072_I2C_NUM, DS13072_i2c_cmd_handle, 1000 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(DS13072_i2c_cmd_handle);
+  esp_err_t ret = i2c_master_cmd_begin(Port, DS13072_i2c_cmd_handle,
+                                       1000 / portTICK_PERIOD_MS);
+  i2c_cmd_link_delete(DS13072_i2c_cmd_handle);
 
-    if (ret == ESP_OK) {
-        printf("DS13072 detected at address 0x68!\n");
-    } else {
-        printf("DS13072 NOT detected. Check wiring!\n");
-    }
+  if (ret == ESP_OK)
+    printf("DS13072 detected at address 0x68 on I2C port %d!\n", (int)Port);
+  else
+    printf("DS13072 NOT detected on I2C port %d. Check wiring!\n", (int)Port);
 
-    return 0;
+  return 0;
 }
 
 
-
-
 static int8_t
-Platform_DeInit(void)
+Platform_PortDeInit(i2c_port_t Port)
 {
-  i2c_driver_delete(DS13072_I2C_NUM);
-  gpio_reset_pin(DS13072_SDA_GPIO);
-  gpio_reset_pin(DS13072_SCL_GPIO);
+  i2c_driver_delete(Port);
+  gpio_reset_pin(Platform_Ports[Port].Sda);
+  gpio_reset_pin(Platform_Ports[Port].Scl);
 
   return 0;
 }
 
 
 static int8_t
-Platform_WriteData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+Platform_PortWriteData(i2c_port_t Port,
+                       uint8_t Address, uint8_t *Data, uint8_t DataLen)
 {
   i2c_cmd_handle_t DS13072_i2c_cmd_handle = 0;
 
@@ -72,7 +109,7 @@ Platform_WriteData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
   i2c_master_write(DS13072_i2c_cmd_handle, &Address, 1, 1);
   i2c_master_write(DS13072_i2c_cmd_handle, Data, DataLen, 1);
   i2c_master_stop(DS13072_i2c_cmd_handle);
-  if (i2c_master_cmd_begin(DS13072_I2C_NUM, DS13072_i2c_cmd_handle,
+  if (i2c_master_cmd_begin(Port, DS13072_i2c_cmd_handle,
                            1000 / portTICK_PERIOD_MS) != ESP_OK)
   {
     i2c_cmd_link_delete(DS13072_i2c_cmd_handle);
@@ -85,7 +122,8 @@ Platform_WriteData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
 
 
 static int8_t
-Platform_ReadData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+Platform_PortReadData(i2c_port_t Port,
+                      uint8_t Address, uint8_t *Data, uint8_t DataLen)
 {
   i2c_cmd_handle_t DS13072_i2c_cmd_handle = 0;
 
@@ -97,7 +135,7 @@ Platform_ReadData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
   i2c_master_write(DS13072_i2c_cmd_handle, &Address, 1, 1);
   i2c_master_read(DS13072_i2c_cmd_handle, Data, DataLen, I2C_MASTER_LAST_NACK);
   i2c_master_stop(DS13072_i2c_cmd_handle);
-  if (i2c_master_cmd_begin(DS13072_I2C_NUM, DS13072_i2c_cmd_handle,
+  if (i2c_master_cmd_begin(Port, DS13072_i2c_cmd_handle,
                            1000 / portTICK_PERIOD_MS) != ESP_OK)
   {
     i2c_cmd_link_delete(DS13072_i2c_cmd_handle);
@@ -109,6 +147,120 @@ Platform_ReadData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
 }
 
 
+static void
+Platform_PortLock(i2c_port_t Port)
+{
+  xSemaphoreTake(Platform_Ports[Port].Bus, portMAX_DELAY);
+}
+
+
+static void
+Platform_PortUnlock(i2c_port_t Port)
+{
+  xSemaphoreGive(Platform_Ports[Port].Bus);
+}
+
+
+/*
+ * The handler functions take no context, so each port gets its own set
+ * that passes the port number on.
+ */
+static int8_t
+Platform_Init0(void)
+{
+  return Platform_PortInit(I2C_NUM_0);
+}
+
+
+static int8_t
+Platform_DeInit0(void)
+{
+  return Platform_PortDeInit(I2C_NUM_0);
+}
+
+
+static int8_t
+Platform_WriteData0(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  return Platform_PortWriteData(I2C_NUM_0, Address, Data, DataLen);
+}
+
+
+static int8_t
+Platform_ReadData0(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  return Platform_PortReadData(I2C_NUM_0, Address, Data, DataLen);
+}
+
+
+static void
+Platform_Lock0(void)
+{
+  Platform_PortLock(I2C_NUM_0);
+}
+
+
+static void
+Platform_Unlock0(void)
+{
+  Platform_PortUnlock(I2C_NUM_0);
+}
+
+#if DS13072_PLATFORM_PORTS > 1
+static int8_t
+Platform_Init1(void)
+{
+  return Platform_PortInit(I2C_NUM_1);
+}
+
+
+static int8_t
+Platform_DeInit1(void)
+{
+  return Platform_PortDeInit(I2C_NUM_1);
+}
+
+
+static int8_t
+Platform_WriteData1(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  return Platform_PortWriteData(I2C_NUM_1, Address, Data, DataLen);
+}
+
+
+static int8_t
+Platform_ReadData1(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  return Platform_PortReadData(I2C_NUM_1, Address, Data, DataLen);
+}
+
+
+static void
+Platform_Lock1(void)
+{
+  Platform_PortLock(I2C_NUM_1);
+}
+
+
+static void
+Platform_Unlock1(void)
+{
+  Platform_PortUnlock(I2C_NUM_1);
+}
+#endif
+
+static const Platform_PortFunctions_t
+Platform_PortFunctions[DS13072_PLATFORM_PORTS] =
+{
+  {Platform_Init0, Platform_DeInit0, Platform_WriteData0, Platform_ReadData0,
+   Platform_Lock0, Platform_Unlock0},
+#if DS13072_PLATFORM_PORTS > 1
+  {Platform_Init1, Platform_DeInit1, Platform_WriteData1, Platform_ReadData1,
+   Platform_Lock1, Platform_Unlock1},
+#endif
+};
+
+
 
 /**
  ==================================================================================
@@ -118,14 +270,63 @@ Platform_ReadData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
 
 /**
  * @brief  Initialize platform device to communicate DS13072.
+ * @note   Uses the I2C port and GPIOs of the configuration.
  * @param  Handler: Pointer to handler
- * @retval None
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to create the mutex.
+ *         - DS13072_INVALID_PARAM: The configured port is not an I2C port of
+ *           the chip.
  */
-void
+DS13072_Result_t
 DS13072_Platform_Init(DS13072_Handler_t *Handler)
 {
-  Handler->PlatformInit = Platform_Init;
-  Handler->PlatformDeInit = Platform_DeInit;
-  Handler->PlatformSend = Platform_WriteData;
-  Handler->PlatformReceive = Platform_ReadData;
-}
\ No newline at end of file
+  return DS13072_Platform_InitPort(Handler, DS13072_I2C_NUM,
+                                   DS13072_SDA_GPIO, DS13072_SCL_GPIO);
+}
+
+
+/**
+ * @brief  Initialize platform device to communicate DS13072 on an I2C port.
+ * @note   Each port has its own platform functions, so one DS13072 per port
+ *         can be used at the same time. The bus rate is DS13072_I2C_RATE.
+ *         The port driver is installed by DS13072_Init.
+ * @note   The register accesses of all tasks that use the handler are
+ *         serialized with a mutex of the port.
+ * @param  Handler: Pointer to handler
+ * @param  Port: I2C port
+ * @param  Sda: SDA GPIO
+ * @param  Scl: SCL GPIO
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to create the mutex.
+ *         - DS13072_INVALID_PARAM: Port is not an I2C port of the chip.
+ */
+DS13072_Result_t
+DS13072_Platform_InitPort(DS13072_Handler_t *Handler, i2c_port_t Port,
+                          gpio_num_t Sda, gpio_num_t Scl)
+{
+  if ((int)Port < 0 || (int)Port >= DS13072_PLATFORM_PORTS)
+    return DS13072_INVALID_PARAM;
+
+  if (!Platform_Ports[Port].Bus)
+  {
+    Platform_Ports[Port].Bus = xSemaphoreCreateMutex();
+    if (!Platform_Ports[Port].Bus)
+      return DS13072_FAIL;
+  }
+
+  Platform_Ports[Port].Sda = Sda;
+  Platform_Ports[Port].Scl = Scl;
+
+  Handler->PlatformInit = Platform_PortFunctions[Port].Init;
+  Handler->PlatformDeInit = Platform_PortFunctions[Port].DeInit;
+  Handler->PlatformSend = Platform_PortFunctions[Port].Send;
+  Handler->PlatformReceive = Platform_PortFunctions[Port].Receive;
+  Handler->PlatformLock = Platform_PortFunctions[Port].Lock;
+  Handler->PlatformUnlock = Platform_PortFunctions[Port].Unlock;
+  return DS13072_OK;
+}
+
+
+
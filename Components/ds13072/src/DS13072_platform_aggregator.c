@@ -0,0 +1,132 @@
+/* Includes ---------------------------------------------------------------------*/
+#include "DS13072_platform.h"
+#include "sdkconfig.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+
+#define DS13072_AGGREGATOR_STACK_SIZE  2560
+
+/**
+ * @brief  Reader tasks of the aggregator; bit i of the event group is set
+ *         when reader i has returned
+ */
+static DS13072_Aggregator_t *Platform_Aggregator = NULL;
+static EventGroupHandle_t Platform_AggregatorEvents = NULL;
+static TaskHandle_t Platform_AggregatorTasks[DS13072_AGGREGATOR_MAX_MEMBERS];
+static uint32_t Platform_AggregatorBusy;
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static int8_t
+Platform_AggregatorGetUs(uint64_t *TimeUs)
+{
+  *TimeUs = esp_timer_get_time();
+  return 0;
+}
+
+
+static void
+Platform_AggregatorTask(void *Arg)
+{
+  uint8_t Index = (uint8_t)(uintptr_t)Arg;
+
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    DS13072_Aggregator_ReadMember(Platform_Aggregator, Index);
+    xEventGroupSetBits(Platform_AggregatorEvents, 1 << Index);
+  }
+}
+
+
+static uint32_t
+Platform_AggregatorReadAll(DS13072_Aggregator_t *Aggregator, uint32_t TimeoutMs)
+{
+  uint32_t Mask = (1UL << Aggregator->Count) - 1;
+  uint32_t Start;
+  uint8_t i;
+
+  // readers that were late last time are only woken once they have returned
+  Platform_AggregatorBusy &= ~xEventGroupGetBits(Platform_AggregatorEvents);
+  Start = Mask & ~Platform_AggregatorBusy;
+  if (!Start)
+    return 0;
+
+  xEventGroupClearBits(Platform_AggregatorEvents, Start);
+  Platform_AggregatorBusy |= Start;
+  for (i = 0; i < Aggregator->Count; i++)
+  {
+    if (Start & (1UL << i))
+      xTaskNotifyGive(Platform_AggregatorTasks[i]);
+  }
+
+  return xEventGroupWaitBits(Platform_AggregatorEvents, Start, pdFALSE, pdTRUE,
+                             pdMS_TO_TICKS(TimeoutMs)) & Start;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Start one reader task per member and set the platform functions of
+ *         the aggregator.
+ * @note   Call after all members are added. Each read wakes the reader tasks
+ *         and waits for them on an event group; a task blocked on a failed
+ *         bus is not woken again until it returns. Only one aggregator is
+ *         supported.
+ * @param  Aggregator: Pointer to aggregator
+ * @param  Priority: FreeRTOS priority of the reader tasks
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to create the tasks or the event group, or
+ *                         the tasks are already started.
+ *         - DS13072_INVALID_PARAM: The aggregator has no members.
+ */
+DS13072_Result_t
+DS13072_Aggregator_Platform_Start(DS13072_Aggregator_t *Aggregator,
+                                  UBaseType_t Priority)
+{
+  uint8_t i;
+
+  if (!Aggregator->Count)
+    return DS13072_INVALID_PARAM;
+
+  if (Platform_Aggregator)
+    return DS13072_FAIL;
+
+  Platform_AggregatorEvents = xEventGroupCreate();
+  if (!Platform_AggregatorEvents)
+    return DS13072_FAIL;
+
+  Platform_Aggregator = Aggregator;
+  Platform_AggregatorBusy = 0;
+  for (i = 0; i < Aggregator->Count; i++)
+  {
+    if (xTaskCreate(Platform_AggregatorTask, "ds13072_agg",
+                    DS13072_AGGREGATOR_STACK_SIZE, (void *)(uintptr_t)i,
+                    Priority, &Platform_AggregatorTasks[i]) != pdPASS)
+    {
+      while (i--)
+        vTaskDelete(Platform_AggregatorTasks[i]);
+      vEventGroupDelete(Platform_AggregatorEvents);
+      Platform_AggregatorEvents = NULL;
+      Platform_Aggregator = NULL;
+      return DS13072_FAIL;
+    }
+  }
+
+  Aggregator->GetMonotonicUs = Platform_AggregatorGetUs;
+  Aggregator->ReadAll = Platform_AggregatorReadAll;
+  return DS13072_OK;
+}
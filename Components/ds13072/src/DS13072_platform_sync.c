@@ -0,0 +1,137 @@
+/* Includes ---------------------------------------------------------------------*/
+#include "DS13072_platform.h"
+#include "sdkconfig.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+
+#if CONFIG_DS13072_SYNC_SQW_GPIO >= 0
+/**
+ * @brief  Last SQW/OUT edge, captured in the GPIO interrupt
+ */
+static volatile int64_t Platform_SqwEdgeUs;
+static SemaphoreHandle_t Platform_SqwSemaphore = NULL;
+#endif
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static int8_t
+Platform_SyncGetMonotonicUs(uint64_t *TimeUs)
+{
+  *TimeUs = esp_timer_get_time();
+  return 0;
+}
+
+
+static void
+Platform_SyncDelayUs(uint32_t DelayUs)
+{
+  const uint32_t TickUs = portTICK_PERIOD_MS * 1000;
+  int64_t Until = esp_timer_get_time() + DelayUs;
+  int64_t Now;
+
+  // sleep for whole ticks, then busy-wait the rest for sub-tick accuracy
+  if (DelayUs >= 2 * TickUs)
+    vTaskDelay(DelayUs / TickUs - 1);
+
+  Now = esp_timer_get_time();
+  if (Until > Now)
+    esp_rom_delay_us(Until - Now);
+}
+
+#if CONFIG_DS13072_SYNC_SQW_GPIO >= 0
+static void IRAM_ATTR
+Platform_SqwIsr(void *Arg)
+{
+  BaseType_t Woken = pdFALSE;
+
+  (void)Arg;
+  Platform_SqwEdgeUs = esp_timer_get_time();
+  xSemaphoreGiveFromISR(Platform_SqwSemaphore, &Woken);
+  if (Woken)
+    portYIELD_FROM_ISR();
+}
+
+
+static int8_t
+Platform_SyncWaitSqwEdge(uint32_t TimeoutMs, uint64_t *EdgeUs)
+{
+  // drop an edge that happened before the call
+  xSemaphoreTake(Platform_SqwSemaphore, 0);
+  if (xSemaphoreTake(Platform_SqwSemaphore,
+                     pdMS_TO_TICKS(TimeoutMs)) != pdTRUE)
+    return -1;
+
+  *EdgeUs = Platform_SqwEdgeUs;
+  return 0;
+}
+
+
+static int8_t
+Platform_SqwInit(void)
+{
+  gpio_config_t conf = {0};
+  esp_err_t Err;
+
+  if (Platform_SqwSemaphore)
+    return 0;
+
+  Platform_SqwSemaphore = xSemaphoreCreateBinary();
+  if (!Platform_SqwSemaphore)
+    return -1;
+
+  conf.pin_bit_mask = 1ULL << CONFIG_DS13072_SYNC_SQW_GPIO;
+  conf.mode = GPIO_MODE_INPUT;
+  conf.pull_up_en = GPIO_PULLUP_ENABLE;
+  conf.intr_type = GPIO_INTR_NEGEDGE;
+  if (gpio_config(&conf) != ESP_OK)
+    return -1;
+
+  // the ISR service may already be installed by the application
+  Err = gpio_install_isr_service(0);
+  if (Err != ESP_OK && Err != ESP_ERR_INVALID_STATE)
+    return -1;
+
+  if (gpio_isr_handler_add(CONFIG_DS13072_SYNC_SQW_GPIO,
+                           Platform_SqwIsr, NULL) != ESP_OK)
+    return -1;
+
+  return 0;
+}
+#endif
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize the platform functions of second-edge synchronization.
+ * @note   Uses esp_timer. If CONFIG_DS13072_SYNC_SQW_GPIO is set, the falling
+ *         edge of SQW/OUT is captured on that GPIO; the edge polarity is
+ *         checked by DS13072_SyncToSecondEdge. MaxReads is not changed.
+ * @param  Sync: Pointer to synchronization parameters
+ * @retval None
+ */
+void
+DS13072_Sync_Platform_Init(DS13072_Sync_t *Sync)
+{
+  Sync->GetMonotonicUs = Platform_SyncGetMonotonicUs;
+  Sync->DelayUs = Platform_SyncDelayUs;
+  Sync->WaitSqwEdge = NULL;
+#if CONFIG_DS13072_SYNC_SQW_GPIO >= 0
+  if (Platform_SqwInit() == 0)
+    Sync->WaitSqwEdge = Platform_SyncWaitSqwEdge;
+#endif
+}
@@ -0,0 +1,165 @@
+/* Includes ---------------------------------------------------------------------*/
+#include <sys/time.h>
+#include "DS13072_platform.h"
+#include "sdkconfig.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define DS13072_SYSCLOCK_STACK_SIZE  2560
+#define DS13072_SYSCLOCK_PRIORITY    (tskIDLE_PRIORITY + 1)
+
+/**
+ * @brief  One-shot timer that wakes the task flushing a held-back
+ *         write-back, and the lock shared by the task and the application
+ */
+static esp_timer_handle_t Platform_SysClockTimer = NULL;
+static TaskHandle_t Platform_SysClockTask = NULL;
+static SemaphoreHandle_t Platform_SysClockMutex = NULL;
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static int8_t
+Platform_GetSystemTime(uint64_t *TimeMs)
+{
+  struct timeval tv;
+
+  if (gettimeofday(&tv, NULL) != 0)
+    return -1;
+
+  *TimeMs = (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+  return 0;
+}
+
+
+static int8_t
+Platform_SetSystemTime(uint64_t TimeMs)
+{
+  struct timeval tv;
+
+  tv.tv_sec = TimeMs / 1000;
+  tv.tv_usec = (TimeMs % 1000) * 1000;
+  if (settimeofday(&tv, NULL) != 0)
+    return -1;
+
+  return 0;
+}
+
+
+static int8_t
+Platform_GetMonotonicTime(uint64_t *TimeMs)
+{
+  *TimeMs = esp_timer_get_time() / 1000;
+  return 0;
+}
+
+
+static void
+Platform_SysClockFlush(void *Arg)
+{
+  // runs in the esp_timer task, which must not wait for the bus
+  (void)Arg;
+  xTaskNotifyGive(Platform_SysClockTask);
+}
+
+
+static void
+Platform_SysClockFlushTask(void *Arg)
+{
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    DS13072_SysClock_Update((DS13072_SysClock_t *)Arg);
+  }
+}
+
+
+static int8_t
+Platform_SysClockSchedule(uint32_t DelayMs)
+{
+  esp_timer_stop(Platform_SysClockTimer);
+  if (esp_timer_start_once(Platform_SysClockTimer,
+                           (uint64_t)DelayMs * 1000) != ESP_OK)
+    return -1;
+
+  return 0;
+}
+
+
+static void
+Platform_SysClockLock(void)
+{
+  xSemaphoreTake(Platform_SysClockMutex, portMAX_DELAY);
+}
+
+
+static void
+Platform_SysClockUnlock(void)
+{
+  xSemaphoreGive(Platform_SysClockMutex);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize the system clock layer of a system clock handler.
+ * @note   Uses gettimeofday()/settimeofday() and esp_timer. A held-back
+ *         write-back is flushed by a low priority task that an esp_timer
+ *         callback wakes, and DS13072_SysClock_Update is serialized with a
+ *         mutex. Handler and the write-back policy fields are not changed.
+ *         Only one system clock handler is supported.
+ * @param  SysClock: Pointer to system clock handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to create the timer, the task or the mutex.
+ */
+DS13072_Result_t
+DS13072_SysClock_Platform_Init(DS13072_SysClock_t *SysClock)
+{
+  esp_timer_create_args_t Args = {0};
+
+  SysClock->GetSystemTime = Platform_GetSystemTime;
+  SysClock->SetSystemTime = Platform_SetSystemTime;
+  SysClock->GetMonotonicTime = Platform_GetMonotonicTime;
+
+  if (!Platform_SysClockMutex)
+  {
+    Platform_SysClockMutex = xSemaphoreCreateMutex();
+    if (!Platform_SysClockMutex)
+      return DS13072_FAIL;
+  }
+
+  if (!Platform_SysClockTask &&
+      xTaskCreate(Platform_SysClockFlushTask, "ds13072_sysclk",
+                  DS13072_SYSCLOCK_STACK_SIZE, SysClock,
+                  DS13072_SYSCLOCK_PRIORITY,
+                  &Platform_SysClockTask) != pdPASS)
+  {
+    Platform_SysClockTask = NULL;
+    return DS13072_FAIL;
+  }
+
+  if (!Platform_SysClockTimer)
+  {
+    Args.callback = Platform_SysClockFlush;
+    Args.name = "ds13072_sysclk";
+    if (esp_timer_create(&Args, &Platform_SysClockTimer) != ESP_OK)
+      return DS13072_FAIL;
+  }
+
+  SysClock->Schedule = Platform_SysClockSchedule;
+  SysClock->Lock = Platform_SysClockLock;
+  SysClock->Unlock = Platform_SysClockUnlock;
+  return DS13072_OK;
+}
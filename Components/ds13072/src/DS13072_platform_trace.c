@@ -0,0 +1,136 @@
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "DS13072_platform.h"
+#include "sdkconfig.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+/**
+ * @brief  Largest possible trace dump
+ */
+#define DS13072_TRACE_DUMP_SIZE  (DS13072_TRACE_HEADER_SIZE + \
+                                  DS13072_TRACE_CAPACITY * \
+                                  (DS13072_TRACE_RECORD_SIZE + \
+                                   DS13072_TRACE_PAYLOAD))
+
+/**
+ * @brief  Buffer used to collect a trace dump before writing it to NVS
+ */
+typedef struct Platform_TraceBuffer_s
+{
+  uint8_t   *Data;
+  uint32_t  Len;   // the dump can exceed 64 KB
+} Platform_TraceBuffer_t;
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint32_t
+Platform_TraceClock(void)
+{
+  return (uint32_t)esp_timer_get_time();
+}
+
+
+static int8_t
+Platform_TraceWriteConsole(void *Context, const uint8_t *Data, uint16_t Len)
+{
+  uint16_t i;
+
+  (void)Context;
+  printf("DS13072_TRACE:");
+  for (i = 0; i < Len; i++)
+    printf("%02x", Data[i]);
+  printf("\n");
+
+  return 0;
+}
+
+
+static int8_t
+Platform_TraceWriteBuffer(void *Context, const uint8_t *Data, uint16_t Len)
+{
+  Platform_TraceBuffer_t *Buffer = (Platform_TraceBuffer_t *)Context;
+
+  if (Buffer->Len + Len > DS13072_TRACE_DUMP_SIZE)
+    return -1;
+
+  memcpy(Buffer->Data + Buffer->Len, Data, Len);
+  Buffer->Len += Len;
+  return 0;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Start recording the transfers of a handler, timestamped with
+ *         esp_timer.
+ * @param  Handler: Pointer to handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: A handler is already traced.
+ */
+DS13072_Result_t
+DS13072_Trace_Platform_Attach(DS13072_Handler_t *Handler)
+{
+  return DS13072_Trace_Attach(Handler, Platform_TraceClock);
+}
+
+
+/**
+ * @brief  Print the recorded transfers on the console.
+ * @note   The binary dump is printed as hex in lines starting with
+ *         "DS13072_TRACE:", which the replay tool reads from a console log.
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ */
+DS13072_Result_t
+DS13072_Trace_Platform_DumpConsole(void)
+{
+  return DS13072_Trace_Dump(Platform_TraceWriteConsole, NULL);
+}
+
+
+/**
+ * @brief  Store the recorded transfers as a blob in NVS.
+ * @note   NVS must be initialized (nvs_flash_init) by the application.
+ * @param  Namespace: NVS namespace
+ * @param  Key: NVS key of the blob
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to allocate memory or to write NVS.
+ */
+DS13072_Result_t
+DS13072_Trace_Platform_DumpNVS(const char *Namespace, const char *Key)
+{
+  Platform_TraceBuffer_t Buffer = {0};
+  DS13072_Result_t Result = DS13072_FAIL;
+  nvs_handle_t Nvs;
+
+  Buffer.Data = malloc(DS13072_TRACE_DUMP_SIZE);
+  if (!Buffer.Data)
+    return DS13072_FAIL;
+
+  if (DS13072_Trace_Dump(Platform_TraceWriteBuffer, &Buffer) == DS13072_OK &&
+      nvs_open(Namespace, NVS_READWRITE, &Nvs) == ESP_OK)
+  {
+    if (nvs_set_blob(Nvs, Key, Buffer.Data, Buffer.Len) == ESP_OK &&
+        nvs_commit(Nvs) == ESP_OK)
+      Result = DS13072_OK;
+    nvs_close(Nvs);
+  }
+
+  free(Buffer.Data);
+  return Result;
+}
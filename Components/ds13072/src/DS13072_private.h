@@ -0,0 +1,94 @@
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _DS13072_PRIVATE_H_
+#define _DS13072_PRIVATE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "DS13072.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+/**
+ * @brief  The DS13072 Address on I2C BUS
+ */
+#define DS13072_ADDRESS  0x68
+
+/**
+ * @brief  Internal Registers Address
+ */
+#define DS13072_SECOND   0x00  // the address of SECOND register in DS13072
+#define DS13072_MINUTE   0x01  // the address of MINUTE register in DS13072
+#define DS13072_HOUR     0x02  // the address of HOUR register in DS13072
+#define DS13072_DAY      0x03  // the address of DAY register in DS13072
+#define DS13072_DATE     0x04  // the address of DATE register in DS13072
+#define DS13072_MONTH    0x05  // the address of MONTH register in DS13072
+#define DS13072_YEAR     0x06  // the address of YEAR register in DS13072
+#define DS13072_CONTROL  0x07  // the address of CONTROL register in DS13072
+
+
+/* Private Macro ----------------------------------------------------------------*/
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+/*
+ * Shared by the translation units of the driver, one per feature, so that
+ * each feature is linked only when it is enabled.
+ */
+
+/**
+ * @brief  Write consecutive registers, split by DS13072_SEND_BUFFER_SIZE,
+ *         under the bus lock of the handler
+ * @retval 0 on success, -1 on a bus error
+ */
+int8_t
+DS13072_WriteRegs(DS13072_Handler_t *Handler,
+                 uint8_t StartReg, uint8_t *Data, uint8_t BytesCount);
+
+/**
+ * @brief  Read consecutive registers in one burst, under the bus lock of
+ *         the handler
+ * @retval 0 on success, -1 on a bus error
+ */
+int8_t
+DS13072_ReadRegs(DS13072_Handler_t *Handler,
+                uint8_t StartReg, uint8_t *Data, uint8_t BytesCount);
+
+
+#if DS13072_USE_12HOUR
+/**
+ * @brief  Check a 12-hour mode hour and set its mode bits in the HOUR
+ *         register value
+ * @retval DS13072_OK, or DS13072_INVALID_PARAM if Hour is not 1 to 12
+ */
+DS13072_Result_t
+DS13072_12Hour_ModeBits(const DS13072_DateTime_t *DateTime, uint8_t *HourReg);
+
+/**
+ * @brief  Convert a 12-hour mode hour to 0 to 23
+ * @retval DS13072_OK, or DS13072_INVALID_PARAM if Hour is not 1 to 12
+ */
+DS13072_Result_t
+DS13072_12Hour_To24(const DS13072_DateTime_t *DateTime, uint8_t *Hour);
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _DS13072_PRIVATE_H_
@@ -0,0 +1,77 @@
+/* Includes ---------------------------------------------------------------------*/
+#include "DS13072_private.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+/**
+ * @brief  CONTROL register bits
+ */ 
+#define DS13072_OUT      7
+#define DS13072_SQWE     4
+#define DS13072_RS0      0
+#define DS13072_RS1      1
+
+
+
+/**
+ ==================================================================================
+                     ##### Public Out Wave Functions #####                         
+ ==================================================================================
+ */
+
+/**
+ * @brief  Set output Wave on SQW/Out pin of DS13072
+ * @param  Handler: Pointer to handler
+ * @param  OutWave: where OutWave Shows different output wave states
+ *         - DS13072_OutWave_Low:    Logic level 0 on the SQW/OUT pin
+ *         - DS13072_OutWave_High:   Logic level 1 on the SQW/OUT pin
+ *         - DS13072_OutWave_1Hz:    Output wave frequency = 1Hz
+ *         - DS13072_OutWave_4KHz:   Output wave frequency = 4.096KHz
+ *         - DS13072_OutWave_8KHz:   Output wave frequency = 8.192KHz
+ *         - DS13072_OutWave_32KHz:  Output wave frequency = 32.768KHz
+ * 
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_SetOutWave(DS13072_Handler_t *Handler, DS13072_OutWave_t OutWave)
+{
+  uint8_t ControlReg;
+
+  switch (OutWave)
+  {
+  case DS13072_OutWave_Low:
+    ControlReg = 0;
+    break;
+
+  case DS13072_OutWave_High:
+    ControlReg = (1 << DS13072_OUT);
+    break;
+
+  case DS13072_OutWave_1Hz:
+    ControlReg = (1 << DS13072_SQWE);
+    break;
+
+  case DS13072_OutWave_4KHz:
+    ControlReg = (1 << DS13072_SQWE) | (1 << DS13072_RS0);
+    break;
+
+  case DS13072_OutWave_8KHz:
+    ControlReg = (1 << DS13072_SQWE) | (1 << DS13072_RS1);
+    break;
+
+  case DS13072_OutWave_32KHz:
+    ControlReg = (1 << DS13072_SQWE) | (3 << DS13072_RS0);
+    break;
+
+  default:
+    return DS13072_INVALID_PARAM;
+  }
+
+  if (DS13072_WriteRegs(Handler, DS13072_CONTROL, &ControlReg, 1) < 0)
+    return DS13072_FAIL;
+
+  return DS13072_OK;
+}
@@ -0,0 +1,255 @@
+/* Includes ---------------------------------------------------------------------*/
+#include "DS13072_private.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+/**
+ * @brief  Second-edge synchronization timing
+ */
+#define DS13072_SYNC_SECOND_US       1000000ULL
+#define DS13072_SYNC_COARSE_US       100000  // first polling interval
+#define DS13072_SYNC_FINE_US         1000    // last polling interval
+#define DS13072_SYNC_GUARD_US        2000    // wake-up margin before an edge
+#define DS13072_SYNC_SQW_TIMEOUT_MS  1500
+#define DS13072_SYNC_SQW_CHECK_US    5000    // check read before a SQW edge
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static void
+DS13072_Sync_WaitUntil(const DS13072_Sync_t *Sync, uint64_t TimeUs)
+{
+  uint64_t Now;
+
+  if (Sync->GetMonotonicUs(&Now) == 0 && TimeUs > Now)
+    Sync->DelayUs(TimeUs - Now);
+}
+
+static int8_t
+DS13072_Sync_ReadSecond(DS13072_Handler_t *Handler, const DS13072_Sync_t *Sync,
+                        DS13072_SyncResult_t *Result, uint8_t *Second,
+                        uint64_t *StartUs, uint64_t *EndUs)
+{
+  if (Sync->GetMonotonicUs(StartUs) < 0)
+    return -1;
+
+  Result->BusReads++;
+  if (DS13072_GetSecond(Handler, Second) != DS13072_OK)
+    return -1;
+
+  if (Sync->GetMonotonicUs(EndUs) < 0)
+    return -1;
+
+  return 0;
+}
+
+/*
+ * Read the seconds register every Interval, starting after the read that
+ * started at *Lo and returned Old, until it changes. On return *Lo is the
+ * start of the last read that returned Old and *Hi the end of the first read
+ * that did not.
+ * Returns 0 if the edge was found, 1 if the read budget ran out and -1 on a
+ * bus error, an unexpected value or no change by Deadline.
+ */
+static int8_t
+DS13072_Sync_Poll(DS13072_Handler_t *Handler, const DS13072_Sync_t *Sync,
+                  uint16_t MaxReads, DS13072_SyncResult_t *Result,
+                  uint8_t Old, uint32_t Interval, uint64_t Deadline,
+                  uint64_t *Lo, uint64_t *Hi)
+{
+  uint64_t Start, End;
+  uint8_t Second;
+
+  for (;;)
+  {
+    if (Result->BusReads >= MaxReads)
+      return 1;
+
+    DS13072_Sync_WaitUntil(Sync, *Lo + Interval);
+    if (DS13072_Sync_ReadSecond(Handler, Sync, Result,
+                                &Second, &Start, &End) < 0)
+      return -1;
+
+    if (Second != Old)
+      break;
+
+    if (Start > Deadline)
+      return -1;
+
+    *Lo = Start;
+  }
+
+  if (Second != (Old + 1) % 60)
+    return -1;
+
+  *Hi = End;
+  return 0;
+}
+
+static DS13072_Result_t
+DS13072_Sync_AddSeconds(const DS13072_DateTime_t *DateTime, uint32_t Seconds,
+                        DS13072_DateTime_t *Result)
+{
+  uint32_t UnixTime;
+
+  // also converts 12-hour mode to 24-hour mode
+  if (DS13072_DateTimeToUnix(DateTime, &UnixTime) != DS13072_OK ||
+      DS13072_UnixToDateTime(UnixTime + Seconds, Result) != DS13072_OK)
+    return DS13072_FAIL;
+
+  return DS13072_OK;
+}
+
+static DS13072_Result_t
+DS13072_Sync_Sqw(DS13072_Handler_t *Handler, const DS13072_Sync_t *Sync,
+                 uint16_t MaxReads, DS13072_SyncResult_t *Result)
+{
+  DS13072_DateTime_t DateTime;
+  uint64_t Edge, NextEdge, Start, End;
+  uint8_t Second;
+
+  if (Result->BusReads + 2 > MaxReads ||
+      Sync->WaitSqwEdge(DS13072_SYNC_SQW_TIMEOUT_MS, &Edge) < 0)
+    return DS13072_FAIL;
+
+  // the seconds register must hold the old value just before the next edge
+  // and the new value just after it; this also rejects the wrong polarity
+  DS13072_Sync_WaitUntil(Sync, Edge + DS13072_SYNC_SECOND_US -
+                               DS13072_SYNC_SQW_CHECK_US);
+  if (DS13072_Sync_ReadSecond(Handler, Sync, Result,
+                              &Second, &Start, &End) < 0 ||
+      Sync->WaitSqwEdge(DS13072_SYNC_SQW_TIMEOUT_MS, &NextEdge) < 0)
+    return DS13072_FAIL;
+
+  if (End >= NextEdge ||
+      NextEdge - Edge < DS13072_SYNC_SECOND_US - DS13072_SYNC_GUARD_US ||
+      NextEdge - Edge > DS13072_SYNC_SECOND_US + DS13072_SYNC_GUARD_US)
+    return DS13072_FAIL;
+
+  Result->BusReads++;
+  if (DS13072_GetDateTime(Handler, &DateTime) != DS13072_OK ||
+      DateTime.Second != (Second + 1) % 60)
+    return DS13072_FAIL;
+
+  Result->EdgeUs = NextEdge;
+  Result->UncertaintyUs = 0;
+  return DS13072_Sync_AddSeconds(&DateTime, 0, &Result->DateTime);
+}
+
+
+
+/**
+ ==================================================================================
+                     ##### Public Synchronization Functions #####                  
+ ==================================================================================
+ */
+
+/**
+ * @brief  Find the monotonic time at which the RTC seconds register rolls over
+ * @note   If WaitSqwEdge is set, SQW/OUT must be set to DS13072_OutWave_1Hz.
+ *         The edge is checked against the seconds register before it is used
+ *         and UncertaintyUs is 0. Otherwise, or if the check fails, the
+ *         seconds register is polled over a few seconds at 100 ms, 10 ms and
+ *         1 ms intervals, each time around the edge predicted by the last
+ *         one. The polling search ends with an uncertainty of about half of
+ *         a read plus 0.5 ms.
+ * @note   If the read budget runs out after the first edge is found, the best
+ *         result so far is returned.
+ * @param  Handler: Pointer to handler
+ * @param  Sync: Pointer to synchronization parameters
+ * @param  Result: Pointer to store the result
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data, the clock is not
+ *                         running, or the read budget ran out before the
+ *                         first edge.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_SyncToSecondEdge(DS13072_Handler_t *Handler,
+                         const DS13072_Sync_t *Sync,
+                         DS13072_SyncResult_t *Result)
+{
+  DS13072_DateTime_t DateTime;
+  uint64_t Lo, Hi, Start, End;
+  uint32_t Interval = DS13072_SYNC_COARSE_US;
+  uint32_t Guard = DS13072_SYNC_GUARD_US;
+  uint32_t Seconds;
+  uint16_t MaxReads;
+  uint8_t Edges = 1;
+  uint8_t Expected;
+  uint8_t Second;
+  int8_t Poll;
+
+  if (!Sync->GetMonotonicUs || !Sync->DelayUs)
+    return DS13072_INVALID_PARAM;
+
+  MaxReads = Sync->MaxReads ? Sync->MaxReads : DS13072_SYNC_MAX_READS;
+  Result->BusReads = 0;
+
+  if (Sync->WaitSqwEdge &&
+      DS13072_Sync_Sqw(Handler, Sync, MaxReads, Result) == DS13072_OK)
+    return DS13072_OK;
+
+  if (Result->BusReads >= MaxReads ||
+      Sync->GetMonotonicUs(&Lo) < 0)
+    return DS13072_FAIL;
+
+  Result->BusReads++;
+  if (DS13072_GetDateTime(Handler, &DateTime) != DS13072_OK)
+    return DS13072_FAIL;
+
+  // coarse search for the first edge; no edge within a second means the
+  // clock is halted
+  if (DS13072_Sync_Poll(Handler, Sync, MaxReads, Result, DateTime.Second,
+                        Interval, Lo + DS13072_SYNC_SECOND_US + Interval,
+                        &Lo, &Hi) != 0)
+    return DS13072_FAIL;
+  Seconds = 1;
+
+  // each finer search starts just before the edge predicted by the last one
+  for (Interval /= 10; Interval >= DS13072_SYNC_FINE_US; )
+  {
+    if (Result->BusReads >= MaxReads)
+      break;
+
+    DS13072_Sync_WaitUntil(Sync, Lo + Edges * DS13072_SYNC_SECOND_US - Guard);
+    if (DS13072_Sync_ReadSecond(Handler, Sync, Result,
+                                &Second, &Start, &End) < 0)
+      return DS13072_FAIL;
+
+    Expected = (DateTime.Second + Seconds + Edges) % 60;
+    if (Second == Expected)
+    {
+      // woke up after the edge: aim at the next one with a wider margin
+      Edges++;
+      Guard = MIN(2 * Guard, DS13072_SYNC_COARSE_US);
+      continue;
+    }
+
+    if (Second != (Expected + 59) % 60)
+      return DS13072_FAIL;
+
+    Poll = DS13072_Sync_Poll(Handler, Sync, MaxReads, Result, Second, Interval,
+                             Hi + Edges * DS13072_SYNC_SECOND_US + Guard,
+                             &Start, &End);
+    if (Poll < 0)
+      return DS13072_FAIL;
+    if (Poll > 0)
+      break;
+
+    Lo = Start;
+    Hi = End;
+    Seconds += Edges;
+    Edges = 1;
+    Interval /= 10;
+  }
+
+  Result->EdgeUs = Lo + (Hi - Lo) / 2;
+  Result->UncertaintyUs = (Hi - Lo + 1) / 2;
+  return DS13072_Sync_AddSeconds(&DateTime, Seconds, &Result->DateTime);
+}
@@ -0,0 +1,225 @@
+/* Includes ---------------------------------------------------------------------*/
+#include "DS13072_sysclock.h"
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+static DS13072_Result_t
+DS13072_SysClock_WriteBack(DS13072_SysClock_t *SysClock,
+                           uint64_t SystemMs, uint64_t MonotonicMs)
+{
+  DS13072_DateTime_t DateTime;
+  uint32_t UnixTime = (uint32_t)(SystemMs / 1000);
+
+  if (DS13072_UnixToDateTime(UnixTime, &DateTime) != DS13072_OK)
+    return DS13072_INVALID_PARAM;
+
+  if (DS13072_SetDateTime(SysClock->Handler, &DateTime) != DS13072_OK)
+    return DS13072_FAIL;
+
+  // writing the seconds register restarts the chip's sub-second countdown, so
+  // from now on the RTC reads UnixTime + (monotonic time elapsed)
+  SysClock->RtcOffsetMs = (int64_t)UnixTime * 1000 - (int64_t)MonotonicMs;
+  SysClock->LastWriteMs = MonotonicMs;
+  SysClock->LastSyncMs = MonotonicMs;
+  SysClock->RtcValid = 1;
+  SysClock->Written = 1;
+  SysClock->Pending = 0;
+  SysClock->WriteCount++;
+
+  return DS13072_OK;
+}
+
+/*
+ * Read the RTC back to follow its drift. At the time of the read the RTC is
+ * somewhere in [Second, Second + 1 s); the predicted RTC time is moved only
+ * as far as needed to fall in that range, so the sub-second phase known
+ * from the last write is kept while the drift stays below a second.
+ */
+static DS13072_Result_t
+DS13072_SysClock_ReadBack(DS13072_SysClock_t *SysClock, uint64_t MonotonicMs)
+{
+  DS13072_DateTime_t DateTime;
+  uint32_t UnixTime;
+  int64_t RtcMs;
+  int64_t PredictedMs;
+
+  if (DS13072_GetDateTime(SysClock->Handler, &DateTime) != DS13072_OK)
+    return DS13072_FAIL;
+
+  SysClock->LastSyncMs = MonotonicMs;
+
+  // RTC lost its time (e.g. backup battery): write the system time back
+  if (DS13072_DateTimeToUnix(&DateTime, &UnixTime) != DS13072_OK)
+  {
+    SysClock->RtcValid = 0;
+    return DS13072_OK;
+  }
+
+  RtcMs = (int64_t)UnixTime * 1000;
+  PredictedMs = (int64_t)MonotonicMs + SysClock->RtcOffsetMs;
+  if (PredictedMs < RtcMs)
+    SysClock->RtcOffsetMs += RtcMs - PredictedMs;
+  else if (PredictedMs > RtcMs + 999)
+    SysClock->RtcOffsetMs -= PredictedMs - (RtcMs + 999);
+
+  return DS13072_OK;
+}
+
+static DS13072_Result_t
+DS13072_SysClock_Check(DS13072_SysClock_t *SysClock)
+{
+  uint64_t SystemMs;
+  uint64_t MonotonicMs;
+  int64_t Divergence;
+
+  if (SysClock->GetMonotonicTime(&MonotonicMs) < 0 ||
+      SysClock->GetSystemTime(&SystemMs) < 0)
+    return DS13072_FAIL;
+
+  if (SysClock->RtcValid &&
+      (MonotonicMs - SysClock->LastSyncMs) >= SysClock->MinIntervalMs &&
+      DS13072_SysClock_ReadBack(SysClock, MonotonicMs) != DS13072_OK)
+    return DS13072_FAIL;
+
+  if (SysClock->RtcValid)
+  {
+    Divergence = ((int64_t)SystemMs - (int64_t)MonotonicMs) -
+                 SysClock->RtcOffsetMs;
+    if (Divergence < 0)
+      Divergence = -Divergence;
+
+    // back in line (e.g. a step that was undone): nothing left to flush
+    if (Divergence <= (int64_t)SysClock->ThresholdMs)
+    {
+      SysClock->Pending = 0;
+      return DS13072_OK;
+    }
+  }
+
+  if (SysClock->Written &&
+      (MonotonicMs - SysClock->LastWriteMs) < SysClock->MinIntervalMs)
+  {
+    // hold the write back; the call at the deadline writes the system time
+    // of that moment, which includes every adjustment made until then. The
+    // deadline only moves with a write, so once pending the call is already
+    // scheduled.
+    if (!SysClock->Pending && SysClock->Schedule &&
+        SysClock->Schedule(SysClock->LastWriteMs + SysClock->MinIntervalMs -
+                           MonotonicMs) < 0)
+      return DS13072_FAIL;
+
+    SysClock->Pending = 1;
+    return DS13072_OK;
+  }
+
+  return DS13072_SysClock_WriteBack(SysClock, SystemMs, MonotonicMs);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Seed the system clock from the RTC.
+ * @note   After it returns, the application can use time()/gettimeofday()
+ *         without any bus traffic.
+ * @note   If the RTC does not hold a valid date and time, the system clock is
+ *         not changed and the first call to DS13072_SysClock_Update writes
+ *         the system time to the RTC.
+ * @param  SysClock: Pointer to system clock handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to read the RTC or to set the system clock.
+ *         - DS13072_INVALID_PARAM: One of parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_SysClock_Init(DS13072_SysClock_t *SysClock)
+{
+  DS13072_DateTime_t DateTime;
+  uint32_t UnixTime;
+  uint64_t MonotonicMs;
+
+  if (!SysClock->Handler ||
+      !SysClock->GetSystemTime ||
+      !SysClock->SetSystemTime ||
+      !SysClock->GetMonotonicTime)
+    return DS13072_INVALID_PARAM;
+
+  if (!SysClock->ThresholdMs)
+    SysClock->ThresholdMs = DS13072_SYSCLOCK_THRESHOLD_MS;
+  if (!SysClock->MinIntervalMs)
+    SysClock->MinIntervalMs = DS13072_SYSCLOCK_MIN_INTERVAL_MS;
+
+  SysClock->RtcOffsetMs = 0;
+  SysClock->LastWriteMs = 0;
+  SysClock->LastSyncMs = 0;
+  SysClock->WriteCount = 0;
+  SysClock->RtcValid = 0;
+  SysClock->Written = 0;
+  SysClock->Pending = 0;
+
+  if (DS13072_GetDateTime(SysClock->Handler, &DateTime) != DS13072_OK)
+    return DS13072_FAIL;
+
+  // RTC was never set (or lost power): leave the system clock alone
+  if (DS13072_DateTimeToUnix(&DateTime, &UnixTime) != DS13072_OK)
+    return DS13072_OK;
+
+  if (SysClock->GetMonotonicTime(&MonotonicMs) < 0)
+    return DS13072_FAIL;
+
+  if (SysClock->SetSystemTime((uint64_t)UnixTime * 1000) < 0)
+    return DS13072_FAIL;
+
+  SysClock->RtcOffsetMs = (int64_t)UnixTime * 1000 - (int64_t)MonotonicMs;
+  SysClock->LastSyncMs = MonotonicMs;
+  SysClock->RtcValid = 1;
+
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Write the system time back to the RTC if they have diverged.
+ * @note   Call this after settimeofday() or from the SNTP sync notification
+ *         callback. The RTC time is predicted from the monotonic clock; the
+ *         RTC is written only when the divergence exceeds ThresholdMs and the
+ *         last write is at least MinIntervalMs old.
+ * @note   A divergence held back by MinIntervalMs is pending: the system time
+ *         of the call at or after the deadline is written, so the last of a
+ *         burst of adjustments reaches the RTC. Schedule is called to make
+ *         that call; without Schedule, call this function periodically.
+ * @note   The RTC crystal drifts from the monotonic clock (about 1.7 s/day at
+ *         20 ppm), so the seconds register is read back at most once per
+ *         MinIntervalMs to correct the prediction.
+ * @param  SysClock: Pointer to system clock handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to read a clock, to read or write the RTC,
+ *                         or to schedule the held-back write.
+ *         - DS13072_INVALID_PARAM: System time is out of the RTC range.
+ */
+DS13072_Result_t
+DS13072_SysClock_Update(DS13072_SysClock_t *SysClock)
+{
+  DS13072_Result_t Result;
+
+  if (SysClock->Lock)
+    SysClock->Lock();
+
+  Result = DS13072_SysClock_Check(SysClock);
+
+  if (SysClock->Unlock)
+    SysClock->Unlock();
+
+  return Result;
+}
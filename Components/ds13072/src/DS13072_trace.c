@@ -0,0 +1,239 @@
+/* Includes ---------------------------------------------------------------------*/
+#include <string.h>
+#include <stdatomic.h>
+#include "DS13072_trace.h"
+
+
+/* Private Macro ----------------------------------------------------------------*/
+#define DS13072_TRACE_MASK  (DS13072_TRACE_CAPACITY - 1)
+
+#if (DS13072_TRACE_CAPACITY < 1) || \
+    (DS13072_TRACE_CAPACITY & DS13072_TRACE_MASK)
+#error "DS13072_TRACE_CAPACITY must be a power of 2"
+#endif
+
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+
+/* Private Types ----------------------------------------------------------------*/
+typedef struct DS13072_TraceRecord_s
+{
+  atomic_uint_fast32_t Sequence;  // index + 1, 0 while being written
+  uint32_t  Start;
+  uint16_t  Duration;
+  uint8_t   Address;
+  uint8_t   Len;
+  int8_t    Result;
+  uint8_t   Data[DS13072_TRACE_PAYLOAD];
+} DS13072_TraceRecord_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static DS13072_TraceRecord_t Trace_Ring[DS13072_TRACE_CAPACITY];
+static atomic_uint_fast32_t Trace_Head;
+static DS13072_Handler_t *Trace_Handler;
+static DS13072_TraceClock_t Trace_Clock;
+static DS13072_PlatformSendReceive_t Trace_Send;
+static DS13072_PlatformSendReceive_t Trace_Receive;
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+static void
+DS13072_Trace_Record(uint8_t Address, const uint8_t *Data, uint8_t Len,
+                     int8_t Result, uint32_t Start, uint32_t End)
+{
+  DS13072_TraceRecord_t *Record;
+  uint32_t Index;
+
+  // claim a slot; concurrent writers get different slots
+  Index = atomic_fetch_add_explicit(&Trace_Head, 1, memory_order_relaxed);
+  Record = &Trace_Ring[Index & DS13072_TRACE_MASK];
+
+  atomic_store_explicit(&Record->Sequence, 0, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  Record->Start = Start;
+  Record->Duration = MIN(End - Start, 0xFFFF);
+  Record->Address = Address;
+  Record->Len = Len;
+  Record->Result = Result;
+  memcpy(Record->Data, Data, MIN(Len, DS13072_TRACE_PAYLOAD));
+
+  atomic_store_explicit(&Record->Sequence, Index + 1, memory_order_release);
+}
+
+static int8_t
+DS13072_Trace_PlatformSend(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint32_t Start = Trace_Clock();
+  int8_t Result = Trace_Send(Address, Data, Len);
+
+  DS13072_Trace_Record(Address, Data, Len, Result, Start, Trace_Clock());
+  return Result;
+}
+
+static int8_t
+DS13072_Trace_PlatformReceive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint32_t Start = Trace_Clock();
+  int8_t Result = Trace_Receive(Address, Data, Len);
+
+  DS13072_Trace_Record(Address | DS13072_TRACE_READ, Data, Len, Result,
+                       Start, Trace_Clock());
+  return Result;
+}
+
+static void
+DS13072_Trace_Put32(uint8_t *Buffer, uint32_t Value)
+{
+  Buffer[0] = Value;
+  Buffer[1] = Value >> 8;
+  Buffer[2] = Value >> 16;
+  Buffer[3] = Value >> 24;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Start recording the transfers of a handler.
+ * @note   The PlatformSend and PlatformReceive functions of the handler are
+ *         wrapped; call this after the platform layer is set and before other
+ *         tasks use the handler. Only one handler can be traced at a time.
+ * @param  Handler: Pointer to handler
+ * @param  Clock: Microsecond clock used for timestamps
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: A handler is already traced or one of
+ *                                  parameters is invalid.
+ */
+DS13072_Result_t
+DS13072_Trace_Attach(DS13072_Handler_t *Handler, DS13072_TraceClock_t Clock)
+{
+  if (Trace_Handler ||
+      !Clock ||
+      !Handler->PlatformSend ||
+      !Handler->PlatformReceive)
+    return DS13072_INVALID_PARAM;
+
+  Trace_Clock = Clock;
+  Trace_Send = Handler->PlatformSend;
+  Trace_Receive = Handler->PlatformReceive;
+  Trace_Handler = Handler;
+
+  Handler->PlatformSend = DS13072_Trace_PlatformSend;
+  Handler->PlatformReceive = DS13072_Trace_PlatformReceive;
+
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Stop recording and restore the platform functions of the handler.
+ * @note   Recorded transfers are kept and can still be dumped.
+ * @param  Handler: Pointer to handler
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: Handler is not traced.
+ */
+DS13072_Result_t
+DS13072_Trace_Detach(DS13072_Handler_t *Handler)
+{
+  if (!Handler || Handler != Trace_Handler)
+    return DS13072_INVALID_PARAM;
+
+  Handler->PlatformSend = Trace_Send;
+  Handler->PlatformReceive = Trace_Receive;
+  Trace_Handler = NULL;
+
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Discard all recorded transfers.
+ * @retval None
+ */
+void
+DS13072_Trace_Clear(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < DS13072_TRACE_CAPACITY; i++)
+    atomic_store_explicit(&Trace_Ring[i].Sequence, 0, memory_order_relaxed);
+  atomic_store_explicit(&Trace_Head, 0, memory_order_release);
+}
+
+
+/**
+ * @brief  Write recorded transfers in the binary dump format.
+ * @note   Lock-free; recording continues while dumping, and records that are
+ *         overwritten during the dump are skipped.
+ * @param  Write: Function that receives the dump in chunks
+ * @param  Context: Pointer passed to Write
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Write failed.
+ */
+DS13072_Result_t
+DS13072_Trace_Dump(DS13072_TraceWrite_t Write, void *Context)
+{
+  uint8_t Buffer[DS13072_TRACE_RECORD_SIZE + DS13072_TRACE_PAYLOAD];
+  DS13072_TraceRecord_t *Record;
+  uint32_t Head;
+  uint32_t Index;
+  uint8_t Stored;
+
+  memcpy(Buffer, DS13072_TRACE_MAGIC, 4);
+  Buffer[4] = DS13072_TRACE_VERSION;
+  Buffer[5] = DS13072_TRACE_PAYLOAD;
+  Buffer[6] = 0;
+  Buffer[7] = 0;
+  if (Write(Context, Buffer, DS13072_TRACE_HEADER_SIZE) < 0)
+    return DS13072_FAIL;
+
+  Head = atomic_load_explicit(&Trace_Head, memory_order_acquire);
+  Index = (Head > DS13072_TRACE_CAPACITY) ? Head - DS13072_TRACE_CAPACITY : 0;
+
+  for (; Index != Head; Index++)
+  {
+    Record = &Trace_Ring[Index & DS13072_TRACE_MASK];
+    if (atomic_load_explicit(&Record->Sequence, memory_order_acquire) !=
+        Index + 1)
+      continue;
+
+    Stored = MIN(Record->Len, DS13072_TRACE_PAYLOAD);
+    DS13072_Trace_Put32(&Buffer[0], Index);
+    DS13072_Trace_Put32(&Buffer[4], Record->Start);
+    Buffer[8] = Record->Duration;
+    Buffer[9] = Record->Duration >> 8;
+    Buffer[10] = Record->Address;
+    Buffer[11] = Record->Len;
+    Buffer[12] = (uint8_t)Record->Result;
+    Buffer[13] = Stored;
+    memcpy(&Buffer[DS13072_TRACE_RECORD_SIZE], Record->Data, Stored);
+
+    // skip the record if a writer reused the slot while it was copied
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&Record->Sequence, memory_order_relaxed) !=
+        Index + 1)
+      continue;
+
+    if (Write(Context, Buffer, DS13072_TRACE_RECORD_SIZE + Stored) < 0)
+      return DS13072_FAIL;
+  }
+
+  return DS13072_OK;
+}
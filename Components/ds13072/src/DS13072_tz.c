@@ -0,0 +1,402 @@
+/* Includes ---------------------------------------------------------------------*/
+#include <string.h>
+#include "DS13072_tz.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define DS13072_TZ_HOUR     3600
+#define DS13072_TZ_DAY      86400UL
+
+
+/* Exported Constants -----------------------------------------------------------*/
+const DS13072_TZ_t DS13072_TZ_UTC =
+  DS13072_TZ_FIXED("UTC", 0);
+
+const DS13072_TZ_t DS13072_TZ_CentralEurope =
+  DS13072_TZ_DST("CET", 1 * DS13072_TZ_HOUR, "CEST", 2 * DS13072_TZ_HOUR,
+                 3, 5, 0, 2 * DS13072_TZ_HOUR,
+                 10, 5, 0, 3 * DS13072_TZ_HOUR);
+
+const DS13072_TZ_t DS13072_TZ_UK =
+  DS13072_TZ_DST("GMT", 0, "BST", 1 * DS13072_TZ_HOUR,
+                 3, 5, 0, 1 * DS13072_TZ_HOUR,
+                 10, 5, 0, 2 * DS13072_TZ_HOUR);
+
+const DS13072_TZ_t DS13072_TZ_USEastern =
+  DS13072_TZ_DST("EST", -5 * DS13072_TZ_HOUR, "EDT", -4 * DS13072_TZ_HOUR,
+                 3, 2, 0, 2 * DS13072_TZ_HOUR,
+                 11, 1, 0, 2 * DS13072_TZ_HOUR);
+
+const DS13072_TZ_t DS13072_TZ_USPacific =
+  DS13072_TZ_DST("PST", -8 * DS13072_TZ_HOUR, "PDT", -7 * DS13072_TZ_HOUR,
+                 3, 2, 0, 2 * DS13072_TZ_HOUR,
+                 11, 1, 0, 2 * DS13072_TZ_HOUR);
+
+const DS13072_TZ_t DS13072_TZ_India =
+  DS13072_TZ_FIXED("IST", 5 * DS13072_TZ_HOUR + 30 * 60);
+
+const DS13072_TZ_t DS13072_TZ_AUEastern =
+  DS13072_TZ_DST("AEST", 10 * DS13072_TZ_HOUR, "AEDT", 11 * DS13072_TZ_HOUR,
+                 10, 1, 0, 2 * DS13072_TZ_HOUR,
+                 4, 1, 0, 3 * DS13072_TZ_HOUR);
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+static const char *
+DS13072_TZ_ParseName(const char *s, char *Name)
+{
+  uint8_t Len = 0;
+  char End = 0;
+
+  if (*s == '<')
+  {
+    End = '>';
+    s++;
+  }
+
+  while (*s && (End ? (*s != End) :
+                ((*s >= 'A' && *s <= 'Z') || (*s >= 'a' && *s <= 'z'))))
+  {
+    if (Len < 7)
+      Name[Len] = *s;
+    Len++;
+    s++;
+  }
+
+  if (End)
+  {
+    if (*s != End)
+      return NULL;
+    s++;
+  }
+
+  if (Len < 3)
+    return NULL;
+
+  Name[Len < 7 ? Len : 7] = '\0';
+  return s;
+}
+
+static const char *
+DS13072_TZ_ParseTime(const char *s, int32_t *Seconds)
+{
+  int32_t Sign = 1;
+  int32_t Value = 0;
+  int32_t Part;
+  uint8_t Field;
+
+  if (*s == '+' || *s == '-')
+  {
+    Sign = (*s == '-') ? -1 : 1;
+    s++;
+  }
+
+  for (Field = 0; Field < 3; Field++)
+  {
+    if (*s < '0' || *s > '9')
+      return NULL;
+
+    for (Part = 0; *s >= '0' && *s <= '9'; s++)
+    {
+      Part = Part * 10 + (*s - '0');
+      if (Part > (Field ? 59 : 167))
+        return NULL;
+    }
+
+    Value = Value * 60 + Part;
+    if (*s != ':')
+      break;
+    s++;
+  }
+
+  for (; Field < 2; Field++)
+    Value *= 60;
+
+  *Seconds = Sign * Value;
+  return s;
+}
+
+static const char *
+DS13072_TZ_ParseRule(const char *s, DS13072_TZRule_t *Rule)
+{
+  uint8_t Values[3];
+  uint8_t i;
+
+  if (*s++ != 'M')
+    return NULL;
+
+  for (i = 0; i < 3; i++)
+  {
+    if (i && *s++ != '.')
+      return NULL;
+    if (*s < '0' || *s > '9')
+      return NULL;
+    Values[i] = *s++ - '0';
+    if (*s >= '0' && *s <= '9')
+      Values[i] = Values[i] * 10 + (*s++ - '0');
+
+    // more than two digits, e.g. "M268.1.0" would wrap to month 12
+    if (*s >= '0' && *s <= '9')
+      return NULL;
+  }
+
+  if (Values[0] < 1 || Values[0] > 12 ||
+      Values[1] < 1 || Values[1] > 5 ||
+      Values[2] > 6)
+    return NULL;
+
+  Rule->Month = Values[0];
+  Rule->Week = Values[1];
+  Rule->WeekDay = Values[2];
+  Rule->Time = 2 * DS13072_TZ_HOUR;
+
+  if (*s == '/')
+    s = DS13072_TZ_ParseTime(s + 1, &Rule->Time);
+
+  return s;
+}
+
+/**
+ * @brief  Local time of a transition rule in the given year (0 to 99)
+ */
+static uint32_t
+DS13072_TZ_RuleTime(const DS13072_TZRule_t *Rule, uint8_t Year)
+{
+  static const uint8_t DaysInMonth[12] =
+    {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  DS13072_DateTime_t DateTime = {0};
+  uint32_t First;
+  uint8_t FirstWeekDay;
+  uint8_t MonthLen;
+  uint8_t Day;
+
+  DateTime.Day = 1;
+  DateTime.Month = Rule->Month;
+  DateTime.Year = Year;
+  DS13072_DateTimeToUnix(&DateTime, &First);
+
+  FirstWeekDay = ((First / DS13072_TZ_DAY) + 4) % 7; // 1970-01-01 was Thursday
+  MonthLen = DaysInMonth[Rule->Month - 1] +
+             ((Rule->Month == 2 && (Year & 3) == 0) ? 1 : 0);
+
+  Day = 1 + (Rule->WeekDay + 7 - FirstWeekDay) % 7 + 7 * (Rule->Week - 1);
+  if (Day > MonthLen)
+    Day -= 7;
+
+  return First + (Day - 1) * DS13072_TZ_DAY + Rule->Time;
+}
+
+/**
+ * @brief  Make sure the cache holds the transitions of the UTC year of Utc
+ */
+static void
+DS13072_TZ_Load(const DS13072_TZ_t *Zone, DS13072_TZCache_t *Cache,
+                uint32_t Utc)
+{
+  DS13072_DateTime_t DateTime;
+  uint8_t Year;
+
+  if (Cache->Zone == Zone && Utc >= Cache->YearStart && Utc < Cache->YearEnd)
+    return;
+
+  DS13072_UnixToDateTime(Utc, &DateTime);
+  Year = DateTime.Year;
+
+  DateTime.Second = 0;
+  DateTime.Minute = 0;
+  DateTime.Hour = 0;
+  DateTime.Day = 1;
+  DateTime.Month = 1;
+  DS13072_DateTimeToUnix(&DateTime, &Cache->YearStart);
+  Cache->YearEnd = Cache->YearStart + (365 + ((Year & 3) == 0)) * DS13072_TZ_DAY;
+
+  if (Zone->HasDst)
+  {
+    Cache->DstStart = DS13072_TZ_RuleTime(&Zone->Start, Year) - Zone->StdOffset;
+    Cache->DstEnd = DS13072_TZ_RuleTime(&Zone->End, Year) - Zone->DstOffset;
+  }
+
+  Cache->Zone = Zone;
+}
+
+static uint8_t
+DS13072_TZ_IsDst(const DS13072_TZ_t *Zone, DS13072_TZCache_t *Cache,
+                 uint32_t Utc)
+{
+  if (!Zone->HasDst)
+    return 0;
+
+  DS13072_TZ_Load(Zone, Cache, Utc);
+
+  // southern hemisphere zones start DST late in the year and end it early
+  if (Cache->DstStart < Cache->DstEnd)
+    return (Utc >= Cache->DstStart && Utc < Cache->DstEnd);
+  else
+    return (Utc >= Cache->DstStart || Utc < Cache->DstEnd);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####
+ ==================================================================================
+ */
+
+/**
+ * @brief  Compile a POSIX TZ string, e.g. "CET-1CEST,M3.5.0,M10.5.0/3"
+ * @note   Only the "Mm.w.d" rule form is supported. Names longer than 7
+ *         characters are truncated. Parse once at startup; conversions use
+ *         the compiled zone.
+ * @param  Posix: TZ string
+ * @param  Zone: pointer to store the compiled zone
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: String is not a supported TZ string.
+ */
+DS13072_Result_t
+DS13072_TZ_Parse(const char *Posix, DS13072_TZ_t *Zone)
+{
+  const char *s = Posix;
+  int32_t Offset;
+
+  memset(Zone, 0, sizeof(*Zone));
+
+  if (!(s = DS13072_TZ_ParseName(s, Zone->StdName)) ||
+      !(s = DS13072_TZ_ParseTime(s, &Offset)))
+    return DS13072_INVALID_PARAM;
+
+  // POSIX offsets are west of UTC
+  Zone->StdOffset = -Offset;
+  Zone->DstOffset = -Offset;
+
+  if (*s == '\0')
+    return DS13072_OK;
+
+  if (!(s = DS13072_TZ_ParseName(s, Zone->DstName)))
+    return DS13072_INVALID_PARAM;
+
+  Zone->DstOffset = Zone->StdOffset + DS13072_TZ_HOUR;
+  if (*s != ',')
+  {
+    if (!(s = DS13072_TZ_ParseTime(s, &Offset)))
+      return DS13072_INVALID_PARAM;
+    Zone->DstOffset = -Offset;
+  }
+
+  if (*s++ != ',' ||
+      !(s = DS13072_TZ_ParseRule(s, &Zone->Start)) ||
+      *s++ != ',' ||
+      !(s = DS13072_TZ_ParseRule(s, &Zone->End)) ||
+      *s != '\0')
+    return DS13072_INVALID_PARAM;
+
+  Zone->HasDst = 1;
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Convert UTC to local time
+ * @note   O(1) while UTC stays in the year held by the cache.
+ * @param  Zone: Pointer to zone
+ * @param  Cache: Pointer to transition cache of the caller
+ * @param  Utc: Unix time (2000 to 2099)
+ * @param  Local: pointer to store local time, as Unix time
+ * @param  IsDst: pointer to store 1 if DST is in effect (can be NULL)
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: Utc is outside 2000 to 2099.
+ */
+DS13072_Result_t
+DS13072_TZ_UtcToLocal(const DS13072_TZ_t *Zone, DS13072_TZCache_t *Cache,
+                      uint32_t Utc, uint32_t *Local, uint8_t *IsDst)
+{
+  uint8_t Dst;
+
+  if (Utc < DS13072_UNIX_2000 || Utc >= DS13072_UNIX_2100)
+    return DS13072_INVALID_PARAM;
+
+  Dst = DS13072_TZ_IsDst(Zone, Cache, Utc);
+  *Local = Utc + (Dst ? Zone->DstOffset : Zone->StdOffset);
+
+  if (IsDst)
+    *IsDst = Dst;
+
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Convert local time to UTC
+ * @note   A local time that occurs twice when DST ends is taken as daylight
+ *         time. A local time skipped when DST starts is taken as standard
+ *         time, like mktime() with tm_isdst = -1.
+ * @param  Zone: Pointer to zone
+ * @param  Cache: Pointer to transition cache of the caller
+ * @param  Local: local time, as Unix time
+ * @param  Utc: pointer to store Unix time
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_INVALID_PARAM: Result is outside 2000 to 2099.
+ */
+DS13072_Result_t
+DS13072_TZ_LocalToUtc(const DS13072_TZ_t *Zone, DS13072_TZCache_t *Cache,
+                      uint32_t Local, uint32_t *Utc)
+{
+  uint32_t Candidate;
+
+  if (Zone->HasDst)
+  {
+    Candidate = Local - Zone->DstOffset;
+    if (Candidate >= DS13072_UNIX_2000 && Candidate < DS13072_UNIX_2100 &&
+        DS13072_TZ_IsDst(Zone, Cache, Candidate))
+    {
+      *Utc = Candidate;
+      return DS13072_OK;
+    }
+  }
+
+  Candidate = Local - Zone->StdOffset;
+  if (Candidate < DS13072_UNIX_2000 || Candidate >= DS13072_UNIX_2100)
+    return DS13072_INVALID_PARAM;
+
+  *Utc = Candidate;
+  return DS13072_OK;
+}
+
+
+/**
+ * @brief  Get local date and time from the RTC, which keeps UTC
+ * @param  Handler: Pointer to handler
+ * @param  Zone: Pointer to zone
+ * @param  Cache: Pointer to transition cache of the caller
+ * @param  DateTime: pointer to date and time value structure (24-hour mode)
+ * @param  IsDst: pointer to store 1 if DST is in effect (can be NULL)
+ * @retval DS13072_Result_t
+ *         - DS13072_OK: Operation was successful.
+ *         - DS13072_FAIL: Failed to send or receive data.
+ *         - DS13072_INVALID_PARAM: RTC does not hold a valid date and time.
+ */
+DS13072_Result_t
+DS13072_TZ_GetLocalDateTime(DS13072_Handler_t *Handler,
+                            const DS13072_TZ_t *Zone, DS13072_TZCache_t *Cache,
+                            DS13072_DateTime_t *DateTime, uint8_t *IsDst)
+{
+  uint32_t Utc;
+  uint32_t Local;
+
+  if (DS13072_GetDateTime(Handler, DateTime) != DS13072_OK)
+    return DS13072_FAIL;
+
+  if (DS13072_DateTimeToUnix(DateTime, &Utc) != DS13072_OK ||
+      DS13072_TZ_UtcToLocal(Zone, Cache, Utc, &Local, IsDst) != DS13072_OK)
+    return DS13072_INVALID_PARAM;
+
+  return DS13072_UnixToDateTime(Local, DateTime);
+}
@@ -12,7 +12,7 @@ static const char *TAG = "RTC";
 
 void app_main(void)
 {
-  DS13072_Handler_t Handler;
+  DS13072_Handler_t Handler = {0};
   // set the date and time
   DS13072_DateTime_t DateTime =
   {
@@ -27,12 +27,17 @@ void app_main(void)
     .isPM     = 1  // 1 = PM , 0 = AM
   };
 
-  DS13072_Platform_Init(&Handler);
+  if(DS13072_Platform_Init(&Handler) != DS13072_OK){
+    ESP_LOGE(TAG, "Failed to set up I2C port %d", CONFIG_DS13072_I2C_NUM);
+    return;
+  }
   DS13072_Init(&Handler);
   if(DS13072_SetDateTime(&Handler, &DateTime) != ESP_OK){
      ESP_LOGI(TAG, "Failed to set date and time");
   }
+#if DS13072_USE_SQW
   DS13072_SetOutWave(&Handler, DS13072_OutWave_1Hz);
+#endif
 
   while (1)
   {
@@ -0,0 +1,397 @@
+/**
+ **********************************************************************************
+ * @file   ds13072_aggsim.c
+ * @brief  Host tool: run the DS13072 aggregator against simulated chips that
+ *         are healthy, drifting, stuck, absent or on a hung bus, and report
+ *         the vote and the aggregate read latency.
+ *
+ *         Build (from the tools directory):
+ *           make ds13072_aggsim
+ *
+ *         Usage:
+ *           ds13072_aggsim
+ *
+ *         Every chip is on its own simulated bus served by its own thread;
+ *         transfers take real time at 100 kHz. The monotonic clock moves one
+ *         second forward between reads without waiting. Exits with 3 if a
+ *         vote differs from the expected one.
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "DS13072.h"
+#include "DS13072_aggregator.h"
+#include "ds13072_simchip.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define SIM_BIT_US          10             // 100 kHz bus
+#define SIM_HUNG_US         200000         // bus timeout of a hung bus
+#define SIM_BASE_TIME       1717243200UL   // 2024-06-01 12:00:00
+#define SIM_ROUNDS          6
+#define SIM_MAX_DEVICES     4
+
+
+/* Private Types ----------------------------------------------------------------*/
+typedef enum Sim_Kind_e
+{
+  Sim_None = 0,     // no chip
+  Sim_Good,         // runs in step with the monotonic clock
+  Sim_Drift,        // gains 1.5 s per second
+  Sim_Stuck,        // time does not advance
+  Sim_Absent,       // does not ACK
+  Sim_Hung,         // bus hangs until the bus timeout
+} Sim_Kind_t;
+
+typedef struct Sim_Scenario_s
+{
+  const char            *Name;
+  Sim_Kind_t            Kinds[SIM_MAX_DEVICES];
+  DS13072_Result_t      Result;
+  DS13072_Confidence_t  Confidence;
+  uint8_t               AgreeMask;
+  uint8_t               FailedMask;
+  uint8_t               StuckMask;
+} Sim_Scenario_t;
+
+typedef struct Sim_Device_s
+{
+  Sim_Kind_t  Kind;
+  SimChip_t   Chip;
+} Sim_Device_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static Sim_Device_t Devices[SIM_MAX_DEVICES];
+static _Atomic uint64_t VirtualOffsetUs;
+static uint64_t StartUs;
+
+static DS13072_Aggregator_t *WorkerAggregator;
+static pthread_t Workers[SIM_MAX_DEVICES];
+static pthread_mutex_t WorkerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t WorkerWake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t WorkerDone = PTHREAD_COND_INITIALIZER;
+static uint32_t WorkerStart;
+static uint32_t WorkerDoneMask;
+static uint32_t WorkerBusy;
+static uint8_t WorkerStop;
+
+static const Sim_Scenario_t Scenarios[] =
+{
+  {"healthy",     {Sim_Good, Sim_Good, Sim_Good},
+   DS13072_OK,   DS13072_Confidence_All,      0x7, 0x0, 0x0},
+  {"stuck",       {Sim_Good, Sim_Good, Sim_Stuck},
+   DS13072_OK,   DS13072_Confidence_Majority, 0x3, 0x0, 0x4},
+  {"drifting",    {Sim_Good, Sim_Drift, Sim_Good},
+   DS13072_OK,   DS13072_Confidence_Majority, 0x5, 0x0, 0x0},
+  {"absent",      {Sim_Good, Sim_Good, Sim_Absent},
+   DS13072_OK,   DS13072_Confidence_Majority, 0x3, 0x4, 0x0},
+  {"hung-bus",    {Sim_Good, Sim_Hung, Sim_Good},
+   DS13072_OK,   DS13072_Confidence_Majority, 0x5, 0x2, 0x0},
+  {"one-left",    {Sim_Good, Sim_Absent, Sim_Stuck},
+   DS13072_OK,   DS13072_Confidence_None,     0x1, 0x2, 0x4},
+  {"four",        {Sim_Good, Sim_Good, Sim_Drift, Sim_Good},
+   DS13072_OK,   DS13072_Confidence_Majority, 0xB, 0x0, 0x0},
+  {"none-left",   {Sim_Absent, Sim_Hung},
+   DS13072_FAIL, DS13072_Confidence_None,     0x0, 0x3, 0x0},
+};
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+static uint64_t
+Sim_RealUs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void
+Sim_SleepUs(uint32_t Us)
+{
+  struct timespec ts = {Us / 1000000, (Us % 1000000) * 1000};
+
+  while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    ;
+}
+
+static int8_t
+Sim_GetMonotonicUs(uint64_t *TimeUs)
+{
+  *TimeUs = Sim_RealUs() - StartUs + VirtualOffsetUs;
+  return 0;
+}
+
+static int8_t
+Sim_Send(uint8_t Bus, uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  Sim_Device_t *Device = &Devices[Bus];
+
+  if (Device->Kind == Sim_Hung)
+  {
+    Sim_SleepUs(SIM_HUNG_US);
+    return -1;
+  }
+
+  // the address byte is sent before the missing ACK is seen
+  if (Device->Kind == Sim_Absent ||
+      SimChip_Send(&Device->Chip, Address, Data, Len) < 0)
+  {
+    Sim_SleepUs(11 * SIM_BIT_US);
+    return -3;
+  }
+
+  Sim_SleepUs((2 + 9 * (1 + Len)) * SIM_BIT_US);
+  return 0;
+}
+
+static int8_t
+Sim_Receive(uint8_t Bus, uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  Sim_Device_t *Device = &Devices[Bus];
+  uint64_t NowUs;
+  uint32_t UnixTime;
+
+  if (Device->Kind != Sim_Good && Device->Kind != Sim_Drift &&
+      Device->Kind != Sim_Stuck)
+    return -1;
+
+  Sim_GetMonotonicUs(&NowUs);
+  UnixTime = SIM_BASE_TIME;
+  if (Device->Kind == Sim_Good)
+    UnixTime += NowUs / 1000000;
+  else if (Device->Kind == Sim_Drift)
+    UnixTime += NowUs * 5 / 2 / 1000000;
+
+  SimChip_SetTime(&Device->Chip, UnixTime);
+  if (SimChip_Receive(&Device->Chip, Address, Data, Len) < 0)
+    return -3;
+
+  Sim_SleepUs((2 + 9 * (1 + Len)) * SIM_BIT_US);
+  return 0;
+}
+
+/**
+ * @brief  One set of platform functions per bus, as on a real board
+ */
+#define SIM_BUS(n)                                                              \
+static int8_t                                                                   \
+Sim_Send##n(uint8_t Address, uint8_t *Data, uint8_t Len)                        \
+{                                                                               \
+  return Sim_Send(n, Address, Data, Len);                                       \
+}                                                                               \
+static int8_t                                                                   \
+Sim_Receive##n(uint8_t Address, uint8_t *Data, uint8_t Len)                     \
+{                                                                               \
+  return Sim_Receive(n, Address, Data, Len);                                    \
+}
+
+SIM_BUS(0)
+SIM_BUS(1)
+SIM_BUS(2)
+SIM_BUS(3)
+
+static const DS13072_PlatformSendReceive_t SimSend[SIM_MAX_DEVICES] =
+  {Sim_Send0, Sim_Send1, Sim_Send2, Sim_Send3};
+static const DS13072_PlatformSendReceive_t SimReceive[SIM_MAX_DEVICES] =
+  {Sim_Receive0, Sim_Receive1, Sim_Receive2, Sim_Receive3};
+
+
+/**
+ * @brief  Reader thread of a member, the host version of the reader task
+ */
+static void *
+Sim_Worker(void *Arg)
+{
+  uint32_t Bit = 1UL << (uintptr_t)Arg;
+
+  pthread_mutex_lock(&WorkerLock);
+  for (;;)
+  {
+    while (!(WorkerStart & Bit) && !WorkerStop)
+      pthread_cond_wait(&WorkerWake, &WorkerLock);
+    if (WorkerStop)
+      break;
+    WorkerStart &= ~Bit;
+    pthread_mutex_unlock(&WorkerLock);
+
+    DS13072_Aggregator_ReadMember(WorkerAggregator, (uint8_t)(uintptr_t)Arg);
+
+    pthread_mutex_lock(&WorkerLock);
+    WorkerDoneMask |= Bit;
+    pthread_cond_broadcast(&WorkerDone);
+  }
+  pthread_mutex_unlock(&WorkerLock);
+
+  return NULL;
+}
+
+static uint32_t
+Sim_ReadAll(DS13072_Aggregator_t *Aggregator, uint32_t TimeoutMs)
+{
+  uint32_t Mask = (1UL << Aggregator->Count) - 1;
+  struct timespec Deadline;
+  uint32_t Start;
+  uint32_t Done;
+
+  clock_gettime(CLOCK_REALTIME, &Deadline);
+  Deadline.tv_sec += TimeoutMs / 1000;
+  Deadline.tv_nsec += (long)(TimeoutMs % 1000) * 1000000;
+  if (Deadline.tv_nsec >= 1000000000)
+  {
+    Deadline.tv_sec++;
+    Deadline.tv_nsec -= 1000000000;
+  }
+
+  pthread_mutex_lock(&WorkerLock);
+  // readers that were late last time are only woken once they have returned
+  WorkerBusy &= ~WorkerDoneMask;
+  Start = Mask & ~WorkerBusy;
+  WorkerDoneMask &= ~Start;
+  WorkerBusy |= Start;
+  WorkerStart |= Start;
+  pthread_cond_broadcast(&WorkerWake);
+
+  while ((WorkerDoneMask & Start) != Start)
+  {
+    if (pthread_cond_timedwait(&WorkerDone, &WorkerLock, &Deadline) == ETIMEDOUT)
+      break;
+  }
+  Done = WorkerDoneMask & Start;
+  pthread_mutex_unlock(&WorkerLock);
+
+  return Done;
+}
+
+static void
+Sim_StartWorkers(DS13072_Aggregator_t *Aggregator)
+{
+  uintptr_t i;
+
+  WorkerAggregator = Aggregator;
+  WorkerStart = 0;
+  WorkerDoneMask = 0;
+  WorkerBusy = 0;
+  WorkerStop = 0;
+  for (i = 0; i < Aggregator->Count; i++)
+    pthread_create(&Workers[i], NULL, Sim_Worker, (void *)i);
+}
+
+static void
+Sim_StopWorkers(DS13072_Aggregator_t *Aggregator)
+{
+  uint8_t i;
+
+  pthread_mutex_lock(&WorkerLock);
+  WorkerStop = 1;
+  pthread_cond_broadcast(&WorkerWake);
+  pthread_mutex_unlock(&WorkerLock);
+
+  for (i = 0; i < Aggregator->Count; i++)
+    pthread_join(Workers[i], NULL);
+}
+
+/**
+ * @brief  Run a scenario; returns 0 if the last vote is the expected one
+ */
+static int
+Sim_Run(const Sim_Scenario_t *Scenario)
+{
+  static DS13072_Handler_t Handlers[SIM_MAX_DEVICES];
+  DS13072_Aggregator_t Aggregator = {0};
+  DS13072_AggregatorResult_t Result;
+  DS13072_DateTime_t DateTime;
+  DS13072_Result_t Status = DS13072_FAIL;
+  uint64_t Parallel = 0;
+  uint64_t Sequential = 0;
+  uint64_t Start;
+  uint8_t Round;
+  uint8_t i;
+
+  DS13072_Aggregator_Init(&Aggregator);
+  Aggregator.GetMonotonicUs = Sim_GetMonotonicUs;
+  Aggregator.ReadAll = Sim_ReadAll;
+  for (i = 0; i < SIM_MAX_DEVICES && Scenario->Kinds[i] != Sim_None; i++)
+  {
+    SimChip_Init(&Devices[i].Chip);
+    Devices[i].Kind = Scenario->Kinds[i];
+    Handlers[i].PlatformSend = SimSend[i];
+    Handlers[i].PlatformReceive = SimReceive[i];
+    DS13072_Aggregator_AddMember(&Aggregator, &Handlers[i], NULL);
+  }
+
+  StartUs = Sim_RealUs();
+  VirtualOffsetUs = 0;
+  Sim_StartWorkers(&Aggregator);
+
+  for (Round = 0; Round < SIM_ROUNDS; Round++)
+  {
+    Status = DS13072_Aggregator_Read(&Aggregator, &Result);
+    Parallel += Result.LatencyUs;
+
+    // the same reads one chip after another, for comparison
+    Start = Sim_RealUs();
+    for (i = 0; i < Aggregator.Count; i++)
+      DS13072_GetDateTime(&Handlers[i], &DateTime);
+    Sequential += Sim_RealUs() - Start;
+
+    VirtualOffsetUs += 1000000;
+  }
+
+  Sim_StopWorkers(&Aggregator);
+
+  printf("%-10s %-4s %-8s agree 0x%X failed 0x%X stuck 0x%X  "
+         "parallel %6.2f ms  sequential %6.2f ms\n",
+         Scenario->Name, (Status == DS13072_OK) ? "OK" : "FAIL",
+         (Result.Confidence == DS13072_Confidence_All) ? "all" :
+         (Result.Confidence == DS13072_Confidence_Majority) ? "majority" :
+                                                              "none",
+         Result.AgreeMask, Result.FailedMask, Result.StuckMask,
+         Parallel / 1000.0 / SIM_ROUNDS, Sequential / 1000.0 / SIM_ROUNDS);
+
+  return (Status == Scenario->Result &&
+          Result.Confidence == Scenario->Confidence &&
+          Result.AgreeMask == Scenario->AgreeMask &&
+          Result.FailedMask == Scenario->FailedMask &&
+          Result.StuckMask == Scenario->StuckMask) ? 0 : -1;
+}
+
+
+
+/**
+ ==================================================================================
+                                ##### Main #####
+ ==================================================================================
+ */
+
+int
+main(void)
+{
+  int Status = 0;
+  size_t i;
+
+  for (i = 0; i < sizeof(Scenarios) / sizeof(Scenarios[0]); i++)
+  {
+    if (Sim_Run(&Scenarios[i]) != 0)
+    {
+      printf("  unexpected vote in scenario %s\n", Scenarios[i].Name);
+      Status = 3;
+    }
+  }
+
+  return Status;
+}
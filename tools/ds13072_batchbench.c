@@ -0,0 +1,368 @@
+/**
+ **********************************************************************************
+ * @file   ds13072_batchbench.c
+ * @brief  Host tool: check the DS13072 batch conversions against the scalar
+ *         driver functions and measure records per second of both.
+ *
+ *         Build (from the tools directory):
+ *           make ds13072_batchbench
+ *
+ *         Built with -O3 -march=x86-64-v3 (BATCH_CFLAGS). Add
+ *         EXTRA_CFLAGS=-fopt-info-vec to see which loops of DS13072_batch.c
+ *         are vectorized.
+ *
+ *         Usage:
+ *           ds13072_batchbench [records]
+ *
+ *         The records are random snapshots in 24-hour and 12-hour mode, about
+ *         one in eight with a BCD digit or a date that does not exist. The
+ *         scalar baseline decodes each record with DS13072_RegsToDateTime
+ *         and DS13072_DateTimeToUnix, the way DS13072_GetDateTime callers
+ *         do. Exits with 3 if a batch result or validity bit differs from the
+ *         scalar one.
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "DS13072.h"
+#include "DS13072_batch.h"
+#include "ds13072_simchip.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define BENCH_MIN_NS      200000000ULL  // time each measurement at least this
+
+
+/* Private Types ----------------------------------------------------------------*/
+typedef struct Bench_Data_s
+{
+  uint32_t            Count;
+  uint8_t             (*Regs)[7];
+  DS13072_DateTime_t  *DateTime;
+  DS13072_DateTimeArrays_t Arrays;
+  uint32_t            *UnixIn;
+  uint32_t            *UnixOut;
+  uint32_t            *Valid;
+  uint32_t            Sink;
+} Bench_Data_t;
+
+typedef void (*Bench_Run_t)(Bench_Data_t *Data);
+
+
+/* Private Variables ------------------------------------------------------------*/
+static uint64_t RandomState = 0x9E3779B97F4A7C15ULL;
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+static uint32_t
+Bench_Random(void)
+{
+  RandomState ^= RandomState << 13;
+  RandomState ^= RandomState >> 7;
+  RandomState ^= RandomState << 17;
+  return (uint32_t)(RandomState >> 32);
+}
+
+static uint64_t
+Bench_NowNs(void)
+{
+  struct timespec Ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+  return (uint64_t)Ts.tv_sec * 1000000000ULL + Ts.tv_nsec;
+}
+
+static void
+Bench_Fill(Bench_Data_t *Data)
+{
+  uint32_t i;
+
+  for (i = 0; i < Data->Count; i++)
+  {
+    uint32_t UnixTime = DS13072_UNIX_2000 +
+                        Bench_Random() % (DS13072_UNIX_2100 - DS13072_UNIX_2000);
+    uint8_t *Regs = Data->Regs[i];
+    uint32_t Damage = Bench_Random();
+
+    // 12-hour mode for odd Damage
+    SimChip_UnixToRegs(UnixTime, Damage & 1, Regs, NULL);
+
+    switch ((Damage >> 1) & 15)
+    {
+    case 0:   // digit out of range
+      Regs[(Damage >> 8) % 7] |= 0x0A;
+      break;
+    case 1:   // day that does not exist
+      Regs[4] = SimChip_DECtoBCD(29 + (Damage >> 8) % 3);
+      Regs[5] = 0x02;
+      break;
+    default:
+      break;
+    }
+
+    Data->UnixIn[i] = (Damage & 0x300) ? UnixTime : Bench_Random();
+  }
+
+  // the structure and array inputs hold the decoded snapshots
+  for (i = 0; i < Data->Count; i++)
+  {
+    DS13072_RegsToDateTime(Data->Regs[i], &Data->DateTime[i]);
+    Data->Arrays.Second[i] = Data->DateTime[i].Second;
+    Data->Arrays.Minute[i] = Data->DateTime[i].Minute;
+    Data->Arrays.Hour[i]   = Data->DateTime[i].Hour;
+    Data->Arrays.Day[i]    = Data->DateTime[i].Day;
+    Data->Arrays.Month[i]  = Data->DateTime[i].Month;
+    Data->Arrays.Year[i]   = Data->DateTime[i].Year;
+
+    // arrays are 24-hour
+    if (Data->DateTime[i].HourMode)
+      Data->Arrays.Hour[i] = (Data->DateTime[i].Hour % 12) +
+                             12 * Data->DateTime[i].isPM;
+  }
+}
+
+static int
+Bench_Bit(const uint32_t *Valid, uint32_t i)
+{
+  return (Valid[i / 32] >> (i % 32)) & 1;
+}
+
+/**
+ * @brief  Compare every batch result and validity bit with the scalar one
+ */
+static uint32_t
+Bench_Check(Bench_Data_t *Data)
+{
+  DS13072_DateTime_t DateTime;
+  DS13072_DateTimeArrays_t *A = &Data->Arrays;
+  uint32_t Errors = 0;
+  uint32_t UnixTime;
+  uint32_t i;
+  int Ok;
+
+  DS13072_Batch_RegsToUnix((const uint8_t (*)[7])Data->Regs, Data->UnixOut,
+                           Data->Valid, Data->Count);
+  for (i = 0; i < Data->Count; i++)
+  {
+    Ok = DS13072_RegsToDateTime(Data->Regs[i], &DateTime) == DS13072_OK &&
+         DS13072_DateTimeToUnix(&DateTime, &UnixTime) == DS13072_OK;
+    if (Ok != Bench_Bit(Data->Valid, i) || (Ok && UnixTime != Data->UnixOut[i]))
+      Errors++;
+  }
+
+  DS13072_Batch_DateTimeToUnix(Data->DateTime, Data->UnixOut, Data->Valid,
+                               Data->Count);
+  for (i = 0; i < Data->Count; i++)
+  {
+    Ok = DS13072_DateTimeToUnix(&Data->DateTime[i], &UnixTime) == DS13072_OK;
+    if (Ok != Bench_Bit(Data->Valid, i) || (Ok && UnixTime != Data->UnixOut[i]))
+      Errors++;
+  }
+
+  DS13072_Batch_ArraysToUnix(A, Data->UnixOut, Data->Valid, Data->Count);
+  for (i = 0; i < Data->Count; i++)
+  {
+    memset(&DateTime, 0, sizeof(DateTime));
+    DateTime.Second = A->Second[i];
+    DateTime.Minute = A->Minute[i];
+    DateTime.Hour   = A->Hour[i];
+    DateTime.Day    = A->Day[i];
+    DateTime.Month  = A->Month[i];
+    DateTime.Year   = A->Year[i];
+    Ok = DS13072_DateTimeToUnix(&DateTime, &UnixTime) == DS13072_OK;
+    if (Ok != Bench_Bit(Data->Valid, i) || (Ok && UnixTime != Data->UnixOut[i]))
+      Errors++;
+  }
+
+  // overwrites the arrays; the benchmarks after this only need them filled
+  DS13072_Batch_UnixToArrays(Data->UnixIn, A, Data->Valid, Data->Count);
+  for (i = 0; i < Data->Count; i++)
+  {
+    Ok = DS13072_UnixToDateTime(Data->UnixIn[i], &DateTime) == DS13072_OK;
+    if (Ok != Bench_Bit(Data->Valid, i) ||
+        (Ok && (DateTime.Second != A->Second[i] ||
+                DateTime.Minute != A->Minute[i] ||
+                DateTime.Hour != A->Hour[i] ||
+                DateTime.WeekDay != A->WeekDay[i] ||
+                DateTime.Day != A->Day[i] ||
+                DateTime.Month != A->Month[i] ||
+                DateTime.Year != A->Year[i])))
+      Errors++;
+  }
+
+  return Errors;
+}
+
+static void
+Bench_ScalarRegs(Bench_Data_t *Data)
+{
+  DS13072_DateTime_t DateTime;
+  uint32_t i;
+
+  for (i = 0; i < Data->Count; i++)
+  {
+    if (DS13072_RegsToDateTime(Data->Regs[i], &DateTime) == DS13072_OK &&
+        DS13072_DateTimeToUnix(&DateTime, &Data->UnixOut[i]) == DS13072_OK)
+      Data->Sink++;
+  }
+}
+
+static void
+Bench_BatchRegs(Bench_Data_t *Data)
+{
+  Data->Sink += DS13072_Batch_RegsToUnix((const uint8_t (*)[7])Data->Regs,
+                                         Data->UnixOut, Data->Valid,
+                                         Data->Count);
+}
+
+static void
+Bench_ScalarDateTime(Bench_Data_t *Data)
+{
+  uint32_t i;
+
+  for (i = 0; i < Data->Count; i++)
+  {
+    if (DS13072_DateTimeToUnix(&Data->DateTime[i],
+                               &Data->UnixOut[i]) == DS13072_OK)
+      Data->Sink++;
+  }
+}
+
+static void
+Bench_BatchDateTime(Bench_Data_t *Data)
+{
+  Data->Sink += DS13072_Batch_DateTimeToUnix(Data->DateTime, Data->UnixOut,
+                                             Data->Valid, Data->Count);
+}
+
+static void
+Bench_BatchArrays(Bench_Data_t *Data)
+{
+  Data->Sink += DS13072_Batch_ArraysToUnix(&Data->Arrays, Data->UnixOut,
+                                           Data->Valid, Data->Count);
+}
+
+static void
+Bench_ScalarUnix(Bench_Data_t *Data)
+{
+  DS13072_DateTime_t DateTime;
+  uint32_t i;
+
+  for (i = 0; i < Data->Count; i++)
+  {
+    if (DS13072_UnixToDateTime(Data->UnixIn[i], &DateTime) == DS13072_OK)
+      Data->Sink += DateTime.Day;
+  }
+}
+
+static void
+Bench_BatchUnix(Bench_Data_t *Data)
+{
+  Data->Sink += DS13072_Batch_UnixToArrays(Data->UnixIn, &Data->Arrays,
+                                           Data->Valid, Data->Count);
+}
+
+/**
+ * @brief  Records per second of a conversion
+ */
+static double
+Bench_Measure(Bench_Run_t Run, Bench_Data_t *Data)
+{
+  uint64_t Start = Bench_NowNs();
+  uint64_t Elapsed;
+  uint32_t Rounds = 0;
+
+  do
+  {
+    Run(Data);
+    Rounds++;
+    Elapsed = Bench_NowNs() - Start;
+  } while (Elapsed < BENCH_MIN_NS);
+
+  return (double)Rounds * Data->Count * 1e9 / Elapsed;
+}
+
+static void
+Bench_Report(const char *Name, Bench_Run_t Scalar, Bench_Run_t Batch,
+             Bench_Data_t *Data)
+{
+  double ScalarRate = Scalar ? Bench_Measure(Scalar, Data) : 0;
+  double BatchRate = Bench_Measure(Batch, Data);
+
+  if (Scalar)
+    printf("%-22s %10.1f %10.1f %7.2fx\n", Name, ScalarRate / 1e6,
+           BatchRate / 1e6, BatchRate / ScalarRate);
+  else
+    printf("%-22s %10s %10.1f\n", Name, "-", BatchRate / 1e6);
+}
+
+
+
+/**
+ ==================================================================================
+                                ##### Main #####
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  Bench_Data_t Data;
+  DS13072_DateTimeArrays_t *A = &Data.Arrays;
+  uint32_t Errors;
+
+  memset(&Data, 0, sizeof(Data));
+  Data.Count = 65536;
+  if (argc > 2 || (argc == 2 && (Data.Count = strtoul(argv[1], NULL, 0)) == 0))
+  {
+    fprintf(stderr, "usage: %s [records]\n", argv[0]);
+    return 1;
+  }
+
+  Data.Regs     = malloc(Data.Count * sizeof(*Data.Regs));
+  Data.DateTime = malloc(Data.Count * sizeof(*Data.DateTime));
+  Data.UnixIn   = malloc(Data.Count * sizeof(uint32_t));
+  Data.UnixOut  = malloc(Data.Count * sizeof(uint32_t));
+  Data.Valid    = malloc(DS13072_BATCH_BITMAP_WORDS(Data.Count) *
+                         sizeof(uint32_t));
+  A->Second  = malloc(Data.Count);
+  A->Minute  = malloc(Data.Count);
+  A->Hour    = malloc(Data.Count);
+  A->WeekDay = malloc(Data.Count);
+  A->Day     = malloc(Data.Count);
+  A->Month   = malloc(Data.Count);
+  A->Year    = malloc(Data.Count);
+  if (!Data.Regs || !Data.DateTime || !Data.UnixIn || !Data.UnixOut ||
+      !Data.Valid || !A->Second || !A->Minute || !A->Hour || !A->WeekDay ||
+      !A->Day || !A->Month || !A->Year)
+    return 1;
+
+  Bench_Fill(&Data);
+  Errors = Bench_Check(&Data);
+  Bench_Fill(&Data);
+
+  printf("%u records, million records per second\n", Data.Count);
+  printf("%-22s %10s %10s %8s\n", "conversion", "scalar", "batch", "speedup");
+  Bench_Report("registers to Unix", Bench_ScalarRegs, Bench_BatchRegs, &Data);
+  Bench_Report("structures to Unix", Bench_ScalarDateTime,
+               Bench_BatchDateTime, &Data);
+  Bench_Report("arrays to Unix", NULL, Bench_BatchArrays, &Data);
+  Bench_Report("Unix to arrays", Bench_ScalarUnix, Bench_BatchUnix, &Data);
+
+  if (Errors)
+  {
+    printf("%u batch results differ from the scalar functions\n", Errors);
+    return 3;
+  }
+
+  return (Data.Sink == 0xFFFFFFFF) ? 2 : 0;
+}
@@ -0,0 +1,584 @@
+/**
+ **********************************************************************************
+ * @file   ds13072_bcastsim.c
+ * @brief  Host tool: stress the DS13072 per-second broadcast with hundreds of
+ *         subscriber tasks and lock-free readers, and measure the fan-out
+ *         latency from the second edge of a simulated DS1307.
+ *
+ *         Build (from the tools directory):
+ *           make ds13072_bcastsim
+ *
+ *         Add EXTRA_CFLAGS=-DconfigTICK_RATE_HZ=100 to run with a 10 ms tick.
+ *
+ *         Usage:
+ *           ds13072_bcastsim [seconds] [subscribers]
+ *
+ *         The FreeRTOS functions of tools/host/freertos are implemented here
+ *         on POSIX threads and CLOCK_MONOTONIC. Bus transfers take the time
+ *         of a 100 kHz I2C bus. After a 3 s warm-up the tool counts the bus
+ *         reads per second and, for every published second, the time from
+ *         the edge to the first and the last subscriber that got it. Exits
+ *         with 3 if a subscriber misses a second, a reader gets a torn copy
+ *         or the publisher reads the bus more than expected.
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <errno.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "DS13072.h"
+#include "DS13072_broadcast.h"
+#include "ds13072_simchip.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define SIM_BASE_TIME       1717243200UL  // 2024-06-01 12:00:00
+#define SIM_NS              1000000000ULL
+#define SIM_BYTE_NS         90000ULL      // one byte with ACK at 100 kHz
+#define SIM_WARMUP_S        3
+#define SIM_READERS         4
+#define SIM_READER_BURST    1024          // reads between 1 ms pauses
+#define SIM_MAX_SECONDS     3600
+
+
+/* Private Types ----------------------------------------------------------------*/
+struct tskTaskControlBlock
+{
+  pthread_t       Thread;
+  pthread_mutex_t Mutex;
+  pthread_cond_t  Cond;
+  uint32_t        Notify;
+  TaskFunction_t  Function;
+  void            *Param;
+};
+
+typedef struct Sim_Subscriber_s
+{
+  TaskHandle_t  Task;
+  uint8_t       Id;
+  uint32_t      *LatencyUs;  // by sequence number, 0: not received
+  uint32_t      Received;
+  volatile uint8_t Done;
+} Sim_Subscriber_t;
+
+typedef struct Sim_Reader_s
+{
+  pthread_t     Thread;
+  uint64_t      Reads;
+  uint32_t      Torn;
+} Sim_Reader_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static uint64_t Sim_StartNs;
+static uint64_t Sim_ChipBaseNs;   // monotonic time at which the chip read
+                                  // SIM_BASE_TIME
+static _Thread_local TaskHandle_t Sim_CurrentTask;
+static volatile int Sim_Stop;
+static volatile int Sim_Measuring;
+static uint32_t Sim_MaxSeq;
+
+static SimChip_t Sim_Chip;      // read by the publisher only
+static atomic_uint Sim_ShortReads;
+static atomic_uint Sim_FullReads;
+
+static DS13072_Broadcast_t Broadcast;
+
+
+/**
+ ==================================================================================
+                          ##### FreeRTOS Host Shim #####
+ ==================================================================================
+ */
+
+static uint64_t
+Sim_NowNs(void)
+{
+  struct timespec Ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+  return (uint64_t)Ts.tv_sec * SIM_NS + Ts.tv_nsec;
+}
+
+static void
+Sim_SleepUntilNs(uint64_t TimeNs)
+{
+  struct timespec Ts;
+
+  Ts.tv_sec = TimeNs / SIM_NS;
+  Ts.tv_nsec = TimeNs % SIM_NS;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Ts, NULL) == EINTR)
+    ;
+}
+
+static uint64_t
+Sim_TickNs(TickType_t Tick)
+{
+  return Sim_StartNs + (uint64_t)Tick * SIM_NS / configTICK_RATE_HZ;
+}
+
+static void *
+Sim_TaskEntry(void *Arg)
+{
+  TaskHandle_t Task = (TaskHandle_t)Arg;
+
+  Sim_CurrentTask = Task;
+  Task->Function(Task->Param);
+  return NULL;
+}
+
+BaseType_t
+xTaskCreate(TaskFunction_t Function, const char *Name, uint32_t StackSize,
+            void *Param, UBaseType_t Priority, TaskHandle_t *Handle)
+{
+  pthread_condattr_t Attr;
+  TaskHandle_t Task;
+
+  (void)Name;
+  (void)StackSize;
+  (void)Priority;
+
+  Task = calloc(1, sizeof(*Task));
+  if (!Task)
+    return pdFAIL;
+
+  // notification timeouts are on the monotonic clock
+  pthread_condattr_init(&Attr);
+  pthread_condattr_setclock(&Attr, CLOCK_MONOTONIC);
+  pthread_mutex_init(&Task->Mutex, NULL);
+  pthread_cond_init(&Task->Cond, &Attr);
+  pthread_condattr_destroy(&Attr);
+  Task->Function = Function;
+  Task->Param = Param;
+  if (Handle)
+    *Handle = Task;
+
+  if (pthread_create(&Task->Thread, NULL, Sim_TaskEntry, Task) != 0)
+  {
+    if (Handle)
+      *Handle = NULL;
+    free(Task);
+    return pdFAIL;
+  }
+
+  pthread_detach(Task->Thread);
+  return pdPASS;
+}
+
+void
+vTaskDelete(TaskHandle_t Task)
+{
+  // only self-deletion is used; the control block stays for late notifiers
+  (void)Task;
+  pthread_exit(NULL);
+}
+
+TickType_t
+xTaskGetTickCount(void)
+{
+  return (TickType_t)((Sim_NowNs() - Sim_StartNs) * configTICK_RATE_HZ / SIM_NS);
+}
+
+void
+vTaskDelay(TickType_t Ticks)
+{
+  if (!Ticks)
+  {
+    sched_yield();
+    return;
+  }
+
+  Sim_SleepUntilNs(Sim_TickNs(xTaskGetTickCount() + Ticks));
+}
+
+void
+vTaskDelayUntil(TickType_t *PreviousWakeTime, TickType_t TimeIncrement)
+{
+  TickType_t Wake = *PreviousWakeTime + TimeIncrement;
+
+  if ((int32_t)(Wake - xTaskGetTickCount()) > 0)
+    Sim_SleepUntilNs(Sim_TickNs(Wake));
+  *PreviousWakeTime = Wake;
+}
+
+BaseType_t
+xTaskNotifyGiveIndexed(TaskHandle_t Task, UBaseType_t Index)
+{
+  (void)Index;
+
+  pthread_mutex_lock(&Task->Mutex);
+  Task->Notify++;
+  pthread_cond_signal(&Task->Cond);
+  pthread_mutex_unlock(&Task->Mutex);
+  return pdPASS;
+}
+
+uint32_t
+ulTaskNotifyTakeIndexed(UBaseType_t Index, BaseType_t ClearOnExit,
+                        TickType_t Ticks)
+{
+  TaskHandle_t Task = Sim_CurrentTask;
+  uint64_t DeadlineNs = Sim_NowNs() + (uint64_t)Ticks * SIM_NS / configTICK_RATE_HZ;
+  struct timespec Ts;
+  uint32_t Value;
+
+  (void)Index;
+  Ts.tv_sec = DeadlineNs / SIM_NS;
+  Ts.tv_nsec = DeadlineNs % SIM_NS;
+
+  pthread_mutex_lock(&Task->Mutex);
+  while (!Task->Notify)
+  {
+    if (pthread_cond_timedwait(&Task->Cond, &Task->Mutex, &Ts) == ETIMEDOUT)
+      break;
+  }
+  Value = Task->Notify;
+  if (Value)
+    Task->Notify = ClearOnExit ? 0 : Value - 1;
+  pthread_mutex_unlock(&Task->Mutex);
+
+  return Value;
+}
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+static void
+Sim_BusDelay(uint8_t Bytes)
+{
+  Sim_SleepUntilNs(Sim_NowNs() + Bytes * SIM_BYTE_NS);
+}
+
+/**
+ * @brief  Monotonic time of the edge that starts the given date and time
+ */
+static uint64_t
+Sim_EdgeNs(const DS13072_DateTime_t *DateTime)
+{
+  uint32_t UnixTime;
+
+  if (DS13072_DateTimeToUnix(DateTime, &UnixTime) != DS13072_OK)
+    return 0;
+
+  return Sim_ChipBaseNs + (uint64_t)(UnixTime - SIM_BASE_TIME) * SIM_NS;
+}
+
+static int8_t
+Sim_Send(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  // the publisher only sets the register pointer
+  if (Len != 1 || SimChip_Send(&Sim_Chip, Address, Data, Len) < 0)
+    return -1;
+
+  Sim_BusDelay(Len + 1);
+  return 0;
+}
+
+static int8_t
+Sim_Receive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  // the registers are latched at the start of the read
+  SimChip_SetTime(&Sim_Chip, SIM_BASE_TIME +
+                  (uint32_t)((Sim_NowNs() - Sim_ChipBaseNs) / SIM_NS));
+  if (SimChip_Receive(&Sim_Chip, Address, Data, Len) < 0)
+    return -1;
+
+  Sim_BusDelay(Len + 1);
+
+  if (Len == 1)
+    atomic_fetch_add(&Sim_ShortReads, 1);
+  else
+    atomic_fetch_add(&Sim_FullReads, 1);
+
+  return 0;
+}
+
+static void
+Sim_SubscriberTask(void *Param)
+{
+  Sim_Subscriber_t *Sub = (Sim_Subscriber_t *)Param;
+  DS13072_DateTime_t DateTime;
+  uint64_t EdgeNs;
+  uint64_t NowNs;
+  uint32_t Seq;
+
+  while (!Sim_Stop)
+  {
+    if (!ulTaskNotifyTakeIndexed(DS13072_BROADCAST_NOTIFY_INDEX, pdTRUE,
+                                 pdMS_TO_TICKS(100)))
+      continue;
+
+    if (DS13072_Broadcast_Read(&Broadcast, &DateTime, &Seq) != DS13072_OK)
+      continue;
+
+    NowNs = Sim_NowNs();
+    EdgeNs = Sim_EdgeNs(&DateTime);
+    if (Sim_Measuring && Seq < Sim_MaxSeq && EdgeNs && NowNs > EdgeNs)
+    {
+      Sub->LatencyUs[Seq] = (uint32_t)((NowNs - EdgeNs) / 1000) + 1;
+      Sub->Received++;
+    }
+  }
+
+  Sub->Done = 1;
+  vTaskDelete(NULL);
+}
+
+/**
+ * @brief  Read the last sample at a high rate and check that every copy is
+ *         whole: one sequence number always carries the same time.
+ */
+static void *
+Sim_ReaderThread(void *Arg)
+{
+  Sim_Reader_t *Reader = (Sim_Reader_t *)Arg;
+  DS13072_DateTime_t DateTime;
+  uint32_t LastSeq = 0;
+  uint32_t LastUnix = 0;
+  uint32_t UnixTime;
+  uint32_t Seq;
+
+  while (!Sim_Stop)
+  {
+    // bursts of reads with a pause, so that the readers do not starve the
+    // publisher on a small host
+    if ((++Reader->Reads & (SIM_READER_BURST - 1)) == 0)
+      Sim_SleepUntilNs(Sim_NowNs() + 1000000);
+
+    if (DS13072_Broadcast_Read(&Broadcast, &DateTime, &Seq) != DS13072_OK)
+      continue;
+
+    if (DS13072_DateTimeToUnix(&DateTime, &UnixTime) != DS13072_OK ||
+        (Seq == LastSeq && UnixTime != LastUnix) ||
+        (Seq != LastSeq && LastSeq && UnixTime <= LastUnix))
+      Reader->Torn++;
+
+    LastSeq = Seq;
+    LastUnix = UnixTime;
+  }
+
+  return NULL;
+}
+
+static int
+Sim_CompareU32(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+static void
+Sim_PrintStats(const char *Name, uint32_t *Values, uint32_t Count)
+{
+  if (!Count)
+  {
+    printf("%-26s no samples\n", Name);
+    return;
+  }
+
+  qsort(Values, Count, sizeof(Values[0]), Sim_CompareU32);
+  printf("%-26s p50 %7.3f ms  p99 %7.3f ms  max %7.3f ms\n", Name,
+         Values[Count / 2] / 1000.0, Values[(Count * 99) / 100] / 1000.0,
+         Values[Count - 1] / 1000.0);
+}
+
+
+
+/**
+ ==================================================================================
+                                ##### Main #####
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  DS13072_Handler_t Handler = {0};
+  Sim_Subscriber_t *Subs;
+  Sim_Reader_t Readers[SIM_READERS];
+  uint32_t Seconds = 10;
+  uint32_t Count = DS13072_BROADCAST_MAX_SUBSCRIBERS;
+  uint32_t *First;
+  uint32_t *Last;
+  uint32_t *All;
+  uint32_t Edges = 0;
+  uint32_t AllCount = 0;
+  uint32_t Missed = 0;
+  uint32_t Torn = 0;
+  uint64_t Reads = 0;
+  uint32_t Short0, Full0, Short1, Full1;
+  uint32_t FirstSeq = 0;
+  uint32_t LastSeq = 0;
+  uint64_t MeasureNs;
+  uint32_t Seq;
+  uint32_t i;
+  int Status = 0;
+
+  if (argc > 3 ||
+      (argc > 1 && (Seconds = strtoul(argv[1], NULL, 0)) <= SIM_WARMUP_S) ||
+      (argc > 2 && ((Count = strtoul(argv[2], NULL, 0)) == 0 ||
+                    Count > DS13072_BROADCAST_MAX_SUBSCRIBERS)) ||
+      Seconds > SIM_MAX_SECONDS)
+  {
+    fprintf(stderr, "usage: %s [seconds (> %d)] [subscribers (1 to %d)]\n",
+            argv[0], SIM_WARMUP_S, DS13072_BROADCAST_MAX_SUBSCRIBERS);
+    return 1;
+  }
+
+  Sim_StartNs = Sim_NowNs();
+  srand((unsigned)Sim_StartNs);
+  Sim_ChipBaseNs = Sim_StartNs - (uint64_t)(rand() % 1000) * 1000000ULL;
+  Sim_MaxSeq = Seconds + 8;
+  SimChip_Init(&Sim_Chip);
+
+  Subs = calloc(Count, sizeof(*Subs));
+  First = calloc(Sim_MaxSeq, sizeof(*First));
+  Last = calloc(Sim_MaxSeq, sizeof(*Last));
+  All = calloc((size_t)Count * Sim_MaxSeq, sizeof(*All));
+  if (!Subs || !First || !Last || !All)
+    return 1;
+
+  Handler.PlatformSend = Sim_Send;
+  Handler.PlatformReceive = Sim_Receive;
+  Broadcast.Handler = &Handler;
+  if (DS13072_Broadcast_Start(&Broadcast, 5) != DS13072_OK)
+  {
+    fprintf(stderr, "failed to start the publisher\n");
+    return 1;
+  }
+
+  for (i = 0; i < Count; i++)
+  {
+    Subs[i].LatencyUs = calloc(Sim_MaxSeq, sizeof(uint32_t));
+    if (!Subs[i].LatencyUs ||
+        xTaskCreate(Sim_SubscriberTask, "sub", 2048, &Subs[i], 4,
+                    &Subs[i].Task) != pdPASS ||
+        DS13072_Broadcast_Subscribe(&Broadcast, Subs[i].Task,
+                                    &Subs[i].Id) != DS13072_OK)
+    {
+      fprintf(stderr, "failed to start subscriber %u\n", i);
+      return 1;
+    }
+  }
+
+  for (i = 0; i < SIM_READERS; i++)
+  {
+    memset(&Readers[i], 0, sizeof(Readers[i]));
+    pthread_create(&Readers[i].Thread, NULL, Sim_ReaderThread, &Readers[i]);
+  }
+
+  // let the publisher find the edge, then measure
+  Sim_SleepUntilNs(Sim_StartNs + SIM_WARMUP_S * SIM_NS);
+  Short0 = atomic_load(&Sim_ShortReads);
+  Full0 = atomic_load(&Sim_FullReads);
+  MeasureNs = Sim_NowNs();
+  Sim_Measuring = 1;
+
+  Sim_SleepUntilNs(Sim_StartNs + Seconds * SIM_NS);
+  Sim_Measuring = 0;
+  Short1 = atomic_load(&Sim_ShortReads);
+  Full1 = atomic_load(&Sim_FullReads);
+  MeasureNs = Sim_NowNs() - MeasureNs;
+
+  DS13072_Broadcast_Stop(&Broadcast);
+  Sim_Stop = 1;
+  for (i = 0; i < SIM_READERS; i++)
+  {
+    pthread_join(Readers[i].Thread, NULL);
+    Reads += Readers[i].Reads;
+    Torn += Readers[i].Torn;
+  }
+  for (i = 0; i < Count; i++)
+  {
+    while (!Subs[i].Done)
+      vTaskDelay(1);
+  }
+
+  // seconds that reached at least one subscriber; the first and the last
+  // of them may be cut by the measurement window
+  for (Seq = 0; Seq < Sim_MaxSeq; Seq++)
+  {
+    for (i = 0; i < Count; i++)
+    {
+      if (Subs[i].LatencyUs[Seq])
+      {
+        if (!FirstSeq)
+          FirstSeq = Seq;
+        LastSeq = Seq;
+        break;
+      }
+    }
+  }
+
+  for (Seq = FirstSeq + 1; FirstSeq && Seq < LastSeq; Seq++)
+  {
+    uint32_t Min = UINT32_MAX;
+    uint32_t Max = 0;
+
+    for (i = 0; i < Count; i++)
+    {
+      uint32_t Latency = Subs[i].LatencyUs[Seq];
+
+      if (!Latency)
+      {
+        Missed++;
+        continue;
+      }
+      All[AllCount++] = Latency;
+      if (Latency < Min)
+        Min = Latency;
+      if (Latency > Max)
+        Max = Latency;
+    }
+
+    if (Max)
+    {
+      First[Edges] = Min;
+      Last[Edges] = Max;
+      Edges++;
+    }
+  }
+
+  printf("tick rate                  %u Hz\n", configTICK_RATE_HZ);
+  printf("subscribers                %u (+%d lock-free readers)\n",
+         Count, SIM_READERS);
+  printf("measured                   %.1f s, %u complete seconds\n",
+         MeasureNs / 1e9, Edges);
+  printf("bus reads per second       %.2f seconds register, %.2f date and time\n",
+         (Short1 - Short0) * 1e9 / MeasureNs, (Full1 - Full0) * 1e9 / MeasureNs);
+  Sim_PrintStats("edge to first subscriber", First, Edges);
+  Sim_PrintStats("edge to last subscriber", Last, Edges);
+  Sim_PrintStats("edge to any subscriber", All, AllCount);
+  printf("missed notifications       %u\n", Missed);
+  printf("lock-free reads            %.0f per second, %u torn\n",
+         Reads * 1e9 / (Sim_NowNs() - Sim_StartNs), Torn);
+
+  if (Edges + 3 < (Seconds - SIM_WARMUP_S))
+  {
+    printf("too few seconds published\n");
+    Status = 3;
+  }
+  if ((Full1 - Full0) * 1e9 / MeasureNs > 1.1 ||
+      (Short1 - Short0) * 1e9 / MeasureNs > DS13072_BROADCAST_GUARD_TICKS + 4)
+  {
+    printf("publisher reads the bus more than expected\n");
+    Status = 3;
+  }
+  if (Missed || Torn)
+    Status = 3;
+
+  return Status;
+}
@@ -0,0 +1,324 @@
+/**
+ **********************************************************************************
+ * @file   ds13072_packedsim.c
+ * @brief  Host tool: benchmark the DS13072 packed date and time conversions
+ *         and check that the event log ring survives wraparound, on a
+ *         simulated DS1307 Non-volatile RAM.
+ *
+ *         Build (from the tools directory):
+ *           make ds13072_packedsim
+ *
+ *         Usage:
+ *           ds13072_packedsim [records]
+ *
+ *         The round trips of DS13072_Pack, DS13072_PackRegs and
+ *         DS13072_Unpack are checked on random dates and times before they
+ *         are timed. The event log is filled past its capacity several times,
+ *         re-initialized on the way and interrupted between the entry and the
+ *         header write; after every step it must read back the newest events
+ *         in order. Exits with 3 on a mismatch.
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "DS13072.h"
+#include "DS13072_packed.h"
+#include "ds13072_simchip.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define SIM_MIN_NS          200000000ULL  // time each measurement at least this
+#define SIM_ROUNDS          5             // times the log is filled
+
+
+/* Private Variables ------------------------------------------------------------*/
+static SimChip_t Chip;
+static uint64_t RandomState = 0x9E3779B97F4A7C15ULL;
+static uint32_t Sink;
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+static uint32_t
+Sim_Random(void)
+{
+  RandomState ^= RandomState << 13;
+  RandomState ^= RandomState >> 7;
+  RandomState ^= RandomState << 17;
+  return (uint32_t)(RandomState >> 32);
+}
+
+static uint64_t
+Sim_NowNs(void)
+{
+  struct timespec Ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+  return (uint64_t)Ts.tv_sec * 1000000000ULL + Ts.tv_nsec;
+}
+
+static int8_t
+Sim_Send(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  return SimChip_Send(&Chip, Address, Data, Len);
+}
+
+static int8_t
+Sim_Receive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  return SimChip_Receive(&Chip, Address, Data, Len);
+}
+
+static void
+Sim_RandomRegs(uint8_t Regs[7], DS13072_DateTime_t *DateTime)
+{
+  uint32_t UnixTime = DS13072_UNIX_2000 +
+                      Sim_Random() % (DS13072_UNIX_2100 - DS13072_UNIX_2000);
+
+  SimChip_UnixToRegs(UnixTime, Sim_Random() & 1, Regs, DateTime);
+}
+
+/**
+ * @brief  Check the round trips on random dates and times
+ */
+static uint32_t
+Sim_CheckPacked(uint32_t Count)
+{
+  DS13072_DateTime_t DateTime;
+  DS13072_DateTime_t Unpacked;
+  DS13072_Packed_t Packed;
+  DS13072_Packed_t FromRegs;
+  uint8_t Regs[7];
+  uint32_t Errors = 0;
+  uint32_t i;
+
+  for (i = 0; i < Count; i++)
+  {
+    Sim_RandomRegs(Regs, &DateTime);
+    if (DS13072_Pack(&DateTime, &Packed) != DS13072_OK ||
+        DS13072_PackRegs(Regs, &FromRegs) != DS13072_OK ||
+        FromRegs != Packed ||
+        DS13072_Unpack(Packed, &Unpacked) != DS13072_OK ||
+        memcmp(&Unpacked, &DateTime, sizeof(DateTime)) != 0)
+      Errors++;
+  }
+
+  // ends of the range
+  if (DS13072_Unpack(0, &Unpacked) != DS13072_OK ||
+      Unpacked.Year != 0 || Unpacked.Month != 1 || Unpacked.Day != 1 ||
+      DS13072_Unpack(DS13072_UNIX_2100 - DS13072_PACKED_EPOCH - 1,
+                     &Unpacked) != DS13072_OK ||
+      Unpacked.Year != 99 || Unpacked.Second != 59 ||
+      DS13072_Unpack(DS13072_UNIX_2100 - DS13072_PACKED_EPOCH,
+                     &Unpacked) == DS13072_OK ||
+      DS13072_Unpack(DS13072_PACKED_INVALID, &Unpacked) == DS13072_OK)
+    Errors++;
+
+  // bad digit, 12-hour 0, day that does not exist
+  memcpy(Regs, (const uint8_t[7]){0x5A, 0, 0, 1, 1, 1, 0}, 7);
+  if (DS13072_PackRegs(Regs, &Packed) == DS13072_OK)
+    Errors++;
+  memcpy(Regs, (const uint8_t[7]){0, 0, 0x40, 1, 1, 1, 0}, 7);
+  if (DS13072_PackRegs(Regs, &Packed) == DS13072_OK)
+    Errors++;
+  memcpy(Regs, (const uint8_t[7]){0, 0, 0, 1, 0x30, 2, 0}, 7);
+  if (DS13072_PackRegs(Regs, &Packed) == DS13072_OK)
+    Errors++;
+
+  return Errors;
+}
+
+static void
+Sim_Benchmark(uint32_t Count)
+{
+  DS13072_DateTime_t *DateTime = malloc(Count * sizeof(*DateTime));
+  DS13072_Packed_t *Packed = malloc(Count * sizeof(*Packed));
+  uint8_t (*Regs)[7] = malloc(Count * sizeof(*Regs));
+  DS13072_DateTime_t Unpacked;
+  uint64_t Start;
+  uint64_t Elapsed;
+  uint32_t Rounds;
+  uint32_t i;
+
+  if (!DateTime || !Packed || !Regs)
+    return;
+
+  for (i = 0; i < Count; i++)
+    Sim_RandomRegs(Regs[i], &DateTime[i]);
+
+  Start = Sim_NowNs();
+  for (Rounds = 0; (Elapsed = Sim_NowNs() - Start) < SIM_MIN_NS; Rounds++)
+    for (i = 0; i < Count; i++)
+      Sink += DS13072_Pack(&DateTime[i], &Packed[i]);
+  printf("%-26s %8.1f M/s\n", "DS13072_Pack",
+         (double)Rounds * Count * 1e3 / Elapsed);
+
+  Start = Sim_NowNs();
+  for (Rounds = 0; (Elapsed = Sim_NowNs() - Start) < SIM_MIN_NS; Rounds++)
+    for (i = 0; i < Count; i++)
+      Sink += DS13072_PackRegs(Regs[i], &Packed[i]);
+  printf("%-26s %8.1f M/s\n", "DS13072_PackRegs",
+         (double)Rounds * Count * 1e3 / Elapsed);
+
+  Start = Sim_NowNs();
+  for (Rounds = 0; (Elapsed = Sim_NowNs() - Start) < SIM_MIN_NS; Rounds++)
+    for (i = 0; i < Count; i++)
+    {
+      Sink += DS13072_Unpack(Packed[i], &Unpacked);
+      Sink += Unpacked.Day;
+    }
+  printf("%-26s %8.1f M/s\n", "DS13072_Unpack",
+         (double)Rounds * Count * 1e3 / Elapsed);
+
+  printf("%-26s %5u bytes packed, %u bytes as DS13072_DateTime_t\n",
+         "size", (unsigned)sizeof(DS13072_Packed_t),
+         (unsigned)sizeof(DS13072_DateTime_t));
+
+  free(DateTime);
+  free(Packed);
+  free(Regs);
+}
+
+/**
+ * @brief  Compare the log with the model: the newest Count of Events,
+ *         newest first
+ */
+static int
+Sim_CheckLog(DS13072_Handler_t *Handler, const DS13072_Packed_t *Events,
+             uint32_t Total)
+{
+  DS13072_Packed_t Read[DS13072_EVENTLOG_CAPACITY];
+  uint32_t Expected = Total < DS13072_EVENTLOG_CAPACITY ?
+                      Total : DS13072_EVENTLOG_CAPACITY;
+  uint8_t Count = 0xFF;
+  uint32_t i;
+
+  if (DS13072_EventLog_Read(Handler, Read, &Count) != DS13072_OK ||
+      Count != Expected)
+    return -1;
+
+  for (i = 0; i < Expected; i++)
+  {
+    if (Read[i] != Events[Total - 1 - i])
+      return -1;
+  }
+
+  return 0;
+}
+
+static uint32_t
+Sim_CheckEventLog(DS13072_Handler_t *Handler)
+{
+  DS13072_Packed_t Events[SIM_ROUNDS * DS13072_EVENTLOG_CAPACITY + 8] = {0};
+  DS13072_Packed_t Read[DS13072_EVENTLOG_CAPACITY];
+  uint32_t Errors = 0;
+  uint32_t Total = 0;
+  uint32_t Bytes;
+  uint8_t Count;
+  uint32_t i;
+
+  // lost backup power: random RAM, Init writes an empty log
+  for (i = 0; i < SIMCHIP_REGS; i++)
+    Chip.Regs[i] = Sim_Random();
+  Chip.FailWrite = -1;
+  if (DS13072_EventLog_Init(Handler) != DS13072_OK ||
+      Sim_CheckLog(Handler, Events, 0) != 0)
+    Errors++;
+
+  for (i = 0; i < SIM_ROUNDS * DS13072_EVENTLOG_CAPACITY + 3; i++)
+  {
+    Events[Total] = Sim_Random() % (DS13072_UNIX_2100 - DS13072_UNIX_2000);
+    if (DS13072_EventLog_Append(Handler, Events[Total]) != DS13072_OK)
+      Errors++;
+    Total++;
+
+    if (Sim_CheckLog(Handler, Events, Total) != 0)
+    {
+      printf("log differs after %u events\n", Total);
+      Errors++;
+    }
+
+    // reboot now and then: Init must keep the log
+    if ((i % 7) == 3 &&
+        (DS13072_EventLog_Init(Handler) != DS13072_OK ||
+         Sim_CheckLog(Handler, Events, Total) != 0))
+    {
+      printf("Init lost the log after %u events\n", Total);
+      Errors++;
+    }
+  }
+
+  // power lost between the entry and the header write of an append to a
+  // full log: the old log is kept, except that its oldest slot now holds
+  // the new event
+  Chip.Writes = 0;
+  Chip.FailWrite = 1;
+  if (DS13072_EventLog_Append(Handler, 0x12345678) == DS13072_OK ||
+      DS13072_EventLog_Read(Handler, Read, &Count) != DS13072_OK ||
+      Count != DS13072_EVENTLOG_CAPACITY ||
+      Read[Count - 1] != 0x12345678)
+    Errors++;
+  for (i = 0; i + 1 < Count; i++)
+  {
+    if (Read[i] != Events[Total - 1 - i])
+      Errors++;
+  }
+  Chip.FailWrite = -1;
+
+  // bus traffic of one append and one read
+  Bytes = Chip.Bytes;
+  DS13072_EventLog_Append(Handler, 1);
+  printf("%-26s %5u bytes on the bus\n", "DS13072_EventLog_Append",
+         Chip.Bytes - Bytes);
+  Bytes = Chip.Bytes;
+  DS13072_EventLog_Read(Handler, Read, &Count);
+  printf("%-26s %5u bytes on the bus\n", "DS13072_EventLog_Read",
+         Chip.Bytes - Bytes);
+
+  printf("%-26s %5u appends, capacity %d, %s\n", "event log", Total + 2,
+         DS13072_EVENTLOG_CAPACITY, Errors ? "FAILED" : "ok");
+  return Errors;
+}
+
+
+
+/**
+ ==================================================================================
+                                ##### Main #####
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  DS13072_Handler_t Handler = {0};
+  uint32_t Count = 65536;
+  uint32_t Errors;
+
+  if (argc > 2 || (argc == 2 && (Count = strtoul(argv[1], NULL, 0)) == 0))
+  {
+    fprintf(stderr, "usage: %s [records]\n", argv[0]);
+    return 1;
+  }
+
+  SimChip_Init(&Chip);
+  Handler.PlatformSend = Sim_Send;
+  Handler.PlatformReceive = Sim_Receive;
+
+  Errors = Sim_CheckPacked(Count);
+  if (Errors)
+    printf("%u packed round trips failed\n", Errors);
+
+  Sim_Benchmark(Count);
+  Errors += Sim_CheckEventLog(&Handler);
+
+  return Errors ? 3 : (Sink == 0xFFFFFFFF ? 2 : 0);
+}
@@ -0,0 +1,463 @@
+/**
+ **********************************************************************************
+ * @file   ds13072_replay.c
+ * @brief  Host tool: replay a DS13072 I2C trace against a simulated DS1307
+ *         and report timing and transaction statistics.
+ *
+ *         Build (from the tools directory):
+ *           make ds13072_replay
+ *
+ *         Usage:
+ *           ds13072_replay <trace>
+ *
+ *         <trace> is either a binary dump (DS13072_Trace_Dump or the NVS
+ *         blob) or a console log with "DS13072_TRACE:" lines. Repeated dumps
+ *         in one log are merged by sequence number.
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "DS13072.h"
+#include "DS13072_trace.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define REPLAY_DEVICE_ADDRESS  0x68
+#define REPLAY_REGS_SIZE       64
+#define REPLAY_TIME_REGS       7
+#define REPLAY_LINE_PREFIX     "DS13072_TRACE:"
+
+
+/* Private Types ----------------------------------------------------------------*/
+typedef struct Replay_Record_s
+{
+  uint32_t  Sequence;
+  uint32_t  Start;
+  uint16_t  Duration;
+  uint8_t   Address;
+  uint8_t   Len;
+  int8_t    Result;
+  uint8_t   Stored;
+  uint8_t   Data[255];
+} Replay_Record_t;
+
+typedef struct Replay_Stats_s
+{
+  uint32_t  Count;
+  uint32_t  Bytes;
+  uint32_t  Errors;
+  uint64_t  TotalUs;
+  uint16_t  *Durations;
+} Replay_Stats_t;
+
+typedef struct Replay_Device_s
+{
+  uint8_t   Regs[REPLAY_REGS_SIZE];
+  uint8_t   Known[REPLAY_REGS_SIZE];  // value seen in the trace
+  uint8_t   Pointer;
+  uint8_t   TimeKnown;
+  uint32_t  TimeBase;     // Unix time when the clock was last set
+  uint32_t  TimeBaseUs;   // trace time when the clock was last set
+  uint32_t  Compared;
+  uint32_t  Mismatches;
+  uint32_t  TimeMismatches;
+} Replay_Device_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static Replay_Record_t *Records;
+static uint32_t RecordCount;
+static uint32_t RecordAlloc;
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+static uint32_t
+Replay_Get32(const uint8_t *Buffer)
+{
+  return (uint32_t)Buffer[0] | ((uint32_t)Buffer[1] << 8) |
+         ((uint32_t)Buffer[2] << 16) | ((uint32_t)Buffer[3] << 24);
+}
+
+/**
+ * @brief  Parse one dump and append its records; returns -1 on bad format
+ */
+static int
+Replay_ParseDump(const uint8_t *Data, size_t Len)
+{
+  Replay_Record_t *Record;
+  size_t Pos = DS13072_TRACE_HEADER_SIZE;
+  uint32_t Last = RecordCount ? Records[RecordCount - 1].Sequence : 0;
+
+  if (Len < DS13072_TRACE_HEADER_SIZE ||
+      memcmp(Data, DS13072_TRACE_MAGIC, 4) != 0 ||
+      Data[4] != DS13072_TRACE_VERSION)
+    return -1;
+
+  while (Pos + DS13072_TRACE_RECORD_SIZE <= Len)
+  {
+    if (Pos + DS13072_TRACE_RECORD_SIZE + Data[Pos + 13] > Len)
+      return -1;
+
+    if (RecordCount == RecordAlloc)
+    {
+      RecordAlloc = RecordAlloc ? RecordAlloc * 2 : 256;
+      Records = realloc(Records, RecordAlloc * sizeof(*Records));
+      if (!Records)
+        return -1;
+    }
+
+    Record = &Records[RecordCount];
+    Record->Sequence = Replay_Get32(&Data[Pos]);
+    Record->Start    = Replay_Get32(&Data[Pos + 4]);
+    Record->Duration = Data[Pos + 8] | (Data[Pos + 9] << 8);
+    Record->Address  = Data[Pos + 10];
+    Record->Len      = Data[Pos + 11];
+    Record->Result   = (int8_t)Data[Pos + 12];
+    Record->Stored   = Data[Pos + 13];
+    memcpy(Record->Data, &Data[Pos + DS13072_TRACE_RECORD_SIZE],
+           Record->Stored);
+    Pos += DS13072_TRACE_RECORD_SIZE + Record->Stored;
+
+    // a later dump repeats the records that were still in the ring
+    if (RecordCount && Record->Sequence <= Last)
+      continue;
+    Last = Record->Sequence;
+    RecordCount++;
+  }
+
+  return (Pos == Len) ? 0 : -1;
+}
+
+static int
+Replay_HexValue(char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/**
+ * @brief  Collect "DS13072_TRACE:" lines of a console log into dumps
+ */
+static int
+Replay_ParseLog(const char *Text)
+{
+  uint8_t *Dump = malloc(strlen(Text) / 2 + 1);
+  size_t DumpLen = 0;
+  const char *Line;
+  int Hi, Lo;
+
+  if (!Dump)
+    return -1;
+
+  for (Line = strstr(Text, REPLAY_LINE_PREFIX); Line;
+       Line = strstr(Line, REPLAY_LINE_PREFIX))
+  {
+    Line += strlen(REPLAY_LINE_PREFIX);
+
+    // every dump starts with a line holding only the header
+    if (strncmp(Line, "44535452", 8) == 0 && DumpLen)
+    {
+      if (Replay_ParseDump(Dump, DumpLen) < 0)
+        fprintf(stderr, "warning: skipped a truncated dump\n");
+      DumpLen = 0;
+    }
+
+    while ((Hi = Replay_HexValue(Line[0])) >= 0 &&
+           (Lo = Replay_HexValue(Line[1])) >= 0)
+    {
+      Dump[DumpLen++] = (Hi << 4) | Lo;
+      Line += 2;
+    }
+  }
+
+  if (DumpLen && Replay_ParseDump(Dump, DumpLen) < 0)
+    fprintf(stderr, "warning: skipped a truncated dump\n");
+
+  free(Dump);
+  return RecordCount ? 0 : -1;
+}
+
+static uint8_t
+Replay_DECtoBCD(uint8_t DEC)
+{
+  return ((DEC / 10) << 4) | (DEC % 10);
+}
+
+/**
+ * @brief  Decode time registers the same way as DS13072_GetDateTime
+ */
+static int
+Replay_RegsToUnix(const uint8_t *Regs, uint32_t *UnixTime)
+{
+  DS13072_DateTime_t DateTime;
+
+  if (DS13072_RegsToDateTime(Regs, &DateTime) != DS13072_OK ||
+      DS13072_DateTimeToUnix(&DateTime, UnixTime) != DS13072_OK)
+    return -1;
+
+  return 0;
+}
+
+/**
+ * @brief  Bring the simulated time registers up to the given trace time
+ */
+static void
+Replay_DeviceTick(Replay_Device_t *Device, uint32_t NowUs)
+{
+  DS13072_DateTime_t DateTime;
+  uint32_t UnixTime;
+
+  if (!Device->TimeKnown)
+    return;
+
+  UnixTime = Device->TimeBase + (NowUs - Device->TimeBaseUs) / 1000000;
+  if (DS13072_UnixToDateTime(UnixTime, &DateTime) != DS13072_OK)
+    return;
+
+  Device->Regs[0] = Replay_DECtoBCD(DateTime.Second);
+  Device->Regs[1] = Replay_DECtoBCD(DateTime.Minute);
+  Device->Regs[2] = Replay_DECtoBCD(DateTime.Hour);
+  Device->Regs[4] = Replay_DECtoBCD(DateTime.Day);
+  Device->Regs[5] = Replay_DECtoBCD(DateTime.Month);
+  Device->Regs[6] = Replay_DECtoBCD(DateTime.Year);
+}
+
+static void
+Replay_DeviceSetTime(Replay_Device_t *Device, const uint8_t *Regs,
+                     uint32_t NowUs)
+{
+  if (Replay_RegsToUnix(Regs, &Device->TimeBase) == 0)
+  {
+    Device->TimeBaseUs = NowUs;
+    Device->TimeKnown = 1;
+  }
+}
+
+/**
+ * @brief  Apply one captured transfer to the simulated chip
+ */
+static void
+Replay_DeviceTransfer(Replay_Device_t *Device, const Replay_Record_t *Record)
+{
+  uint8_t Reg;
+  uint8_t i;
+  uint32_t Captured;
+  uint32_t Simulated;
+
+  if ((Record->Address & 0x7F) != REPLAY_DEVICE_ADDRESS || Record->Result < 0)
+    return;
+
+  Replay_DeviceTick(Device, Record->Start);
+
+  if (!(Record->Address & DS13072_TRACE_READ))
+  {
+    if (!Record->Stored)
+      return;
+
+    Device->Pointer = Record->Data[0] % REPLAY_REGS_SIZE;
+    for (i = 1; i < Record->Stored; i++)
+    {
+      Device->Regs[Device->Pointer] = Record->Data[i];
+      Device->Known[Device->Pointer] = 1;
+      Device->Pointer = (Device->Pointer + 1) % REPLAY_REGS_SIZE;
+    }
+    // the chip restarts its clock when the seconds register is written
+    if (Record->Data[0] < REPLAY_TIME_REGS && Record->Stored > 1)
+      Replay_DeviceSetTime(Device, Device->Regs, Record->Start);
+    return;
+  }
+
+  // a burst of all time registers is compared as a time, to within 1 second
+  if (Device->Pointer == 0 && Record->Stored >= REPLAY_TIME_REGS)
+  {
+    if (!Device->TimeKnown)
+    {
+      Replay_DeviceSetTime(Device, Record->Data, Record->Start);
+      memcpy(Device->Regs, Record->Data, REPLAY_TIME_REGS);
+    }
+    else if (Replay_RegsToUnix(Record->Data, &Captured) == 0 &&
+             Replay_RegsToUnix(Device->Regs, &Simulated) == 0)
+    {
+      Device->Compared++;
+      if (Captured + 1 < Simulated || Simulated + 1 < Captured)
+        Device->TimeMismatches++;
+    }
+  }
+
+  for (i = 0; i < Record->Len; i++)
+  {
+    Reg = Device->Pointer;
+    Device->Pointer = (Device->Pointer + 1) % REPLAY_REGS_SIZE;
+    if (i >= Record->Stored || Reg < REPLAY_TIME_REGS)
+      continue;
+
+    // registers written before the capture started are learnt on first read
+    if (!Device->Known[Reg])
+    {
+      Device->Regs[Reg] = Record->Data[i];
+      Device->Known[Reg] = 1;
+      continue;
+    }
+
+    Device->Compared++;
+    if (Device->Regs[Reg] != Record->Data[i])
+      Device->Mismatches++;
+  }
+}
+
+static int
+Replay_CompareU16(const void *a, const void *b)
+{
+  return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+static void
+Replay_PrintStats(const char *Name, Replay_Stats_t *Stats)
+{
+  uint32_t n = Stats->Count;
+
+  if (!n)
+  {
+    printf("  %-8s   0 transfers\n", Name);
+    return;
+  }
+
+  qsort(Stats->Durations, n, sizeof(uint16_t), Replay_CompareU16);
+  printf("  %-8s %6u transfers %8u bytes %5u errors  "
+         "us: min %u  p50 %u  avg %.1f  p99 %u  max %u\n",
+         Name, n, Stats->Bytes, Stats->Errors,
+         Stats->Durations[0], Stats->Durations[n / 2],
+         (double)Stats->TotalUs / n, Stats->Durations[(n * 99) / 100],
+         Stats->Durations[n - 1]);
+}
+
+static uint8_t *
+Replay_ReadFile(const char *Path, size_t *Len)
+{
+  FILE *File = fopen(Path, "rb");
+  uint8_t *Data;
+  long Size;
+
+  if (!File)
+    return NULL;
+
+  fseek(File, 0, SEEK_END);
+  Size = ftell(File);
+  fseek(File, 0, SEEK_SET);
+
+  Data = malloc(Size + 1);
+  if (Data && fread(Data, 1, Size, File) != (size_t)Size)
+  {
+    free(Data);
+    Data = NULL;
+  }
+  fclose(File);
+
+  if (Data)
+  {
+    Data[Size] = '\0';
+    *Len = Size;
+  }
+  return Data;
+}
+
+
+
+/**
+ ==================================================================================
+                                ##### Main #####
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  Replay_Device_t Device = {0};
+  Replay_Stats_t Stats[2] = {{0}};
+  Replay_Record_t *Record;
+  uint64_t BusUs = 0;
+  uint32_t Missing = 0;
+  uint32_t SpanUs;
+  uint8_t *Data;
+  size_t Len;
+  uint32_t i;
+
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: %s <trace>\n", argv[0]);
+    return 2;
+  }
+
+  Data = Replay_ReadFile(argv[1], &Len);
+  if (!Data)
+  {
+    fprintf(stderr, "error: cannot read %s\n", argv[1]);
+    return 1;
+  }
+
+  if ((Len >= 4 && memcmp(Data, DS13072_TRACE_MAGIC, 4) == 0) ?
+      Replay_ParseDump(Data, Len) < 0 : Replay_ParseLog((char *)Data) < 0)
+  {
+    fprintf(stderr, "error: %s is not a DS13072 trace\n", argv[1]);
+    return 1;
+  }
+  free(Data);
+
+  if (!RecordCount)
+  {
+    printf("trace is empty\n");
+    return 0;
+  }
+
+  Stats[0].Durations = malloc(RecordCount * sizeof(uint16_t));
+  Stats[1].Durations = malloc(RecordCount * sizeof(uint16_t));
+  if (!Stats[0].Durations || !Stats[1].Durations)
+    return 1;
+
+  for (i = 0; i < RecordCount; i++)
+  {
+    Record = &Records[i];
+    Replay_Stats_t *s = &Stats[(Record->Address & DS13072_TRACE_READ) ? 1 : 0];
+
+    if (i && Record->Sequence != Records[i - 1].Sequence + 1)
+      Missing += Record->Sequence - Records[i - 1].Sequence - 1;
+
+    s->Durations[s->Count++] = Record->Duration;
+    s->Bytes += Record->Len;
+    s->TotalUs += Record->Duration;
+    if (Record->Result < 0)
+      s->Errors++;
+    BusUs += Record->Duration;
+
+    Replay_DeviceTransfer(&Device, Record);
+  }
+
+  Record = &Records[RecordCount - 1];
+  SpanUs = Record->Start + Record->Duration - Records[0].Start;
+
+  printf("transfers %u (sequence %u to %u, %u not captured)\n",
+         RecordCount, Records[0].Sequence, Record->Sequence, Missing);
+  printf("span %.3f s, %.1f transfers/s, bus busy %.2f%%\n",
+         SpanUs / 1e6, SpanUs ? RecordCount / (SpanUs / 1e6) : 0.0,
+         SpanUs ? 100.0 * BusUs / SpanUs : 0.0);
+  Replay_PrintStats("send", &Stats[0]);
+  Replay_PrintStats("receive", &Stats[1]);
+  printf("replay: %u values compared, %u register mismatches, "
+         "%u time mismatches\n",
+         Device.Compared, Device.Mismatches, Device.TimeMismatches);
+
+  free(Stats[0].Durations);
+  free(Stats[1].Durations);
+  free(Records);
+  return (Device.Mismatches || Device.TimeMismatches) ? 3 : 0;
+}
@@ -0,0 +1,116 @@
+/**
+ **********************************************************************************
+ * @file   ds13072_simchip.c
+ * @brief  Simulated DS1307 shared by the host tools.
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <string.h>
+#include "ds13072_simchip.h"
+
+
+
+/**
+ ==================================================================================
+                             ##### Functions #####
+ ==================================================================================
+ */
+
+uint8_t
+SimChip_DECtoBCD(uint8_t DEC)
+{
+  return ((DEC / 10) << 4) | (DEC % 10);
+}
+
+int8_t
+SimChip_UnixToRegs(uint32_t UnixTime, uint8_t Hour12, uint8_t Regs[7],
+                   DS13072_DateTime_t *DateTime)
+{
+  DS13072_DateTime_t Decoded;
+  uint8_t Hour;
+
+  if (!DateTime)
+    DateTime = &Decoded;
+
+  if (DS13072_UnixToDateTime(UnixTime, DateTime) != DS13072_OK)
+    return -1;
+
+  Regs[0] = SimChip_DECtoBCD(DateTime->Second);
+  Regs[1] = SimChip_DECtoBCD(DateTime->Minute);
+  Regs[2] = SimChip_DECtoBCD(DateTime->Hour);
+  Regs[3] = SimChip_DECtoBCD(DateTime->WeekDay);
+  Regs[4] = SimChip_DECtoBCD(DateTime->Day);
+  Regs[5] = SimChip_DECtoBCD(DateTime->Month);
+  Regs[6] = SimChip_DECtoBCD(DateTime->Year);
+
+  if (Hour12)
+  {
+    Hour = DateTime->Hour % 12;
+    Regs[2] = (1 << DS13072_HOUR_12H) |
+              ((DateTime->Hour >= 12) << DS13072_HOUR_PM) |
+              SimChip_DECtoBCD(Hour ? Hour : 12);
+  }
+
+  return 0;
+}
+
+void
+SimChip_Init(SimChip_t *Chip)
+{
+  memset(Chip, 0, sizeof(*Chip));
+  Chip->FailWrite = -1;
+}
+
+int8_t
+SimChip_SetTime(SimChip_t *Chip, uint32_t UnixTime)
+{
+  return SimChip_UnixToRegs(UnixTime, 0, Chip->Regs, NULL);
+}
+
+int8_t
+SimChip_Send(SimChip_t *Chip, uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint8_t i;
+
+  if (Address != SIMCHIP_ADDRESS || !Len)
+    return -1;
+
+  Chip->Bytes += Len + 1;
+  Chip->Pointer = Data[0] % SIMCHIP_REGS;
+  if (Len == 1)
+    return 0;
+
+  // e.g. power lost before this write
+  if (Chip->FailWrite >= 0 && Chip->Writes == (uint32_t)Chip->FailWrite)
+  {
+    Chip->Writes++;
+    return -1;
+  }
+
+  Chip->Writes++;
+  for (i = 1; i < Len; i++)
+  {
+    Chip->Regs[Chip->Pointer] = Data[i];
+    Chip->Pointer = (Chip->Pointer + 1) % SIMCHIP_REGS;
+  }
+  return 0;
+}
+
+int8_t
+SimChip_Receive(SimChip_t *Chip, uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint8_t i;
+
+  if (Address != SIMCHIP_ADDRESS)
+    return -1;
+
+  Chip->Bytes += Len + 1;
+  Chip->Reads++;
+  for (i = 0; i < Len; i++)
+  {
+    Data[i] = Chip->Regs[Chip->Pointer];
+    Chip->Pointer = (Chip->Pointer + 1) % SIMCHIP_REGS;
+  }
+  return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ **********************************************************************************
+ * @file   ds13072_simchip.h
+ * @brief  Simulated DS1307 shared by the host tools: the 64-byte register
+ *         file behind the register pointer, with bus counters and a write
+ *         failure to inject.
+ *
+ *         The chip does not keep time by itself. Each tool writes the time
+ *         registers of the moment with SimChip_SetTime before a read, and
+ *         wraps SimChip_Send/SimChip_Receive in the platform functions of its
+ *         handler, which take no context, adding its own bus timing.
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _DS13072_SIMCHIP_H_
+#define _DS13072_SIMCHIP_H_
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "DS13072.h"
+
+
+/* Exported Constants -----------------------------------------------------------*/
+#define SIMCHIP_ADDRESS  0x68
+#define SIMCHIP_REGS     64    // time, control and 56 bytes of RAM
+#define SIMCHIP_CONTROL  0x07
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+typedef struct SimChip_s
+{
+  uint8_t   Regs[SIMCHIP_REGS];
+  uint8_t   Pointer;
+  uint32_t  Writes;        // write transfers with data
+  uint32_t  Reads;         // read transfers
+  uint32_t  Bytes;         // bytes on the bus, address bytes included
+  int32_t   FailWrite;     // fail the write transfer with this number, -1: none
+} SimChip_t;
+
+
+
+/**
+ ==================================================================================
+                             ##### Functions #####
+ ==================================================================================
+ */
+
+uint8_t
+SimChip_DECtoBCD(uint8_t DEC);
+
+/**
+ * @brief  Time registers 0x00 to 0x06 of a Unix time, in 12-hour mode if
+ *         Hour12 is set
+ * @param  DateTime: Decoded date and time, can be NULL
+ * @retval 0 on success, -1 if the time is out of the RTC range
+ */
+int8_t
+SimChip_UnixToRegs(uint32_t UnixTime, uint8_t Hour12, uint8_t Regs[7],
+                   DS13072_DateTime_t *DateTime);
+
+/**
+ * @brief  Clear the registers and the counters; no write fails
+ */
+void
+SimChip_Init(SimChip_t *Chip);
+
+/**
+ * @brief  Set the time registers to a Unix time in 24-hour mode; the clock
+ *         halt bit is cleared
+ * @retval 0 on success, -1 if the time is out of the RTC range
+ */
+int8_t
+SimChip_SetTime(SimChip_t *Chip, uint32_t UnixTime);
+
+/**
+ * @brief  Write transfer: the register pointer, then the data bytes
+ * @retval 0 on success, -1 for another address, an empty or a failed write
+ */
+int8_t
+SimChip_Send(SimChip_t *Chip, uint8_t Address, uint8_t *Data, uint8_t Len);
+
+/**
+ * @brief  Read transfer from the register pointer on
+ * @retval 0 on success, -1 for another address
+ */
+int8_t
+SimChip_Receive(SimChip_t *Chip, uint8_t Address, uint8_t *Data, uint8_t Len);
+
+
+#endif //! _DS13072_SIMCHIP_H_
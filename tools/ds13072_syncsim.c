@@ -0,0 +1,321 @@
+/**
+ **********************************************************************************
+ * @file   ds13072_syncsim.c
+ * @brief  Host tool: run DS13072_SyncToSecondEdge against a simulated DS1307
+ *         and report the alignment error and the number of I2C reads used.
+ *
+ *         Build (from the tools directory):
+ *           make ds13072_syncsim
+ *
+ *         Usage:
+ *           ds13072_syncsim [trials]
+ *
+ *         Each scenario runs the given number of trials (default 1000) with a
+ *         random phase of the RTC second. The simulated time advances with
+ *         the I2C transfers (100 kHz), the delays and the SQW interrupts.
+ *         Exits with 3 if an edge is outside the reported uncertainty or a
+ *         scenario that must succeed fails.
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "DS13072.h"
+#include "ds13072_simchip.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define SIM_BIT_US          10             // 100 kHz bus
+#define SIM_BASE_TIME       1735689598UL   // 2024-12-31 23:59:58
+
+
+/* Private Types ----------------------------------------------------------------*/
+typedef enum Sim_Sqw_e
+{
+  Sim_Sqw_None     = 0,  // SQW/OUT not wired
+  Sim_Sqw_Rollover = 1,  // edge at the seconds rollover
+  Sim_Sqw_Middle   = 2,  // edge in the middle of the second
+} Sim_Sqw_t;
+
+typedef struct Sim_Scenario_s
+{
+  const char  *Name;
+  double      DriftPpm;       // RTC frequency error
+  uint32_t    OverheadUs;     // driver overhead per I2C transfer
+  uint32_t    WakeJitterUs;   // maximum extra delay after a DelayUs
+  Sim_Sqw_t   Sqw;
+  uint8_t     Halted;         // CH bit set: the clock does not run
+  uint16_t    MaxReads;
+  uint8_t     MustSucceed;
+} Sim_Scenario_t;
+
+typedef struct Sim_Device_s
+{
+  const Sim_Scenario_t *Scenario;
+  uint64_t  NowUs;
+  double    PhaseUs;   // time of the first rollover
+  double    PeriodUs;  // length of one RTC second
+  SimChip_t Chip;
+} Sim_Device_t;
+
+typedef struct Sim_Stats_s
+{
+  uint32_t  Trials;
+  uint32_t  Success;
+  uint32_t  Outside;      // edge outside EdgeUs +/- UncertaintyUs
+  uint32_t  WrongTime;    // DateTime does not start at the edge
+  double    ErrorSum;
+  double    ErrorMax;
+  double    UncertaintySum;
+  uint32_t  ReadsSum;
+  uint16_t  ReadsMax;
+  double    DurationSum;
+} Sim_Stats_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static Sim_Device_t Device;
+static uint64_t RandomState = 0x2545F4914F6CDD1DULL;
+
+static const Sim_Scenario_t Scenarios[] =
+{
+  {"poll",            0.0,  40,    0, Sim_Sqw_None,     0,  0, 1},
+  {"poll-drift",     80.0,  40,  300, Sim_Sqw_None,     0,  0, 1},
+  {"poll-jitter",   -80.0, 200, 1500, Sim_Sqw_None,     0,  0, 1},
+  {"poll-budget20",   0.0,  40,    0, Sim_Sqw_None,     0, 20, 1},
+  {"sqw",            20.0,  40,  300, Sim_Sqw_Rollover, 0,  0, 1},
+  {"sqw-polarity",   20.0,  40,  300, Sim_Sqw_Middle,   0,  0, 1},
+  {"halted",          0.0,  40,    0, Sim_Sqw_None,     1,  0, 0},
+};
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+static uint32_t
+Sim_Random(uint32_t Max)
+{
+  RandomState ^= RandomState << 13;
+  RandomState ^= RandomState >> 7;
+  RandomState ^= RandomState << 17;
+  return Max ? (uint32_t)(RandomState % (Max + 1)) : 0;
+}
+
+/**
+ * @brief  Unix time held by the RTC at a simulated time
+ */
+static uint32_t
+Sim_RtcTime(uint64_t TimeUs)
+{
+  if (Device.Scenario->Halted || TimeUs < Device.PhaseUs)
+    return SIM_BASE_TIME;
+
+  return SIM_BASE_TIME + 1 +
+         (uint32_t)((TimeUs - Device.PhaseUs) / Device.PeriodUs);
+}
+
+/**
+ * @brief  Simulated time of the rollover to a Unix time
+ */
+static double
+Sim_EdgeUs(uint32_t UnixTime)
+{
+  return Device.PhaseUs + (double)(UnixTime - SIM_BASE_TIME - 1) *
+                          Device.PeriodUs;
+}
+
+static void
+Sim_Transfer(uint8_t Len)
+{
+  // start, address, data with ACK bits, stop
+  Device.NowUs += Device.Scenario->OverheadUs +
+                  (2 + 9 * (1 + Len)) * SIM_BIT_US;
+}
+
+static int8_t
+Sim_Send(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  if (SimChip_Send(&Device.Chip, Address, Data, Len) < 0)
+    return -1;
+
+  Sim_Transfer(Len);
+  return 0;
+}
+
+static int8_t
+Sim_Receive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  // time registers are latched at the START of the transfer
+  SimChip_SetTime(&Device.Chip, Sim_RtcTime(Device.NowUs +
+                                            Device.Scenario->OverheadUs));
+  if (Device.Scenario->Halted)
+    Device.Chip.Regs[0] |= 0x80;
+
+  if (SimChip_Receive(&Device.Chip, Address, Data, Len) < 0)
+    return -1;
+
+  Sim_Transfer(Len);
+  return 0;
+}
+
+static int8_t
+Sim_GetMonotonicUs(uint64_t *TimeUs)
+{
+  *TimeUs = Device.NowUs;
+  return 0;
+}
+
+static void
+Sim_DelayUs(uint32_t DelayUs)
+{
+  Device.NowUs += DelayUs + Sim_Random(Device.Scenario->WakeJitterUs);
+}
+
+static int8_t
+Sim_WaitSqwEdge(uint32_t TimeoutMs, uint64_t *EdgeUs)
+{
+  double Edge = Device.PhaseUs;
+
+  if (Device.Scenario->Sqw == Sim_Sqw_Middle)
+    Edge += Device.PeriodUs / 2;
+  if (Device.NowUs >= Edge)
+    Edge += ((uint64_t)((Device.NowUs - Edge) / Device.PeriodUs) + 1) *
+            Device.PeriodUs;
+
+  if (Edge > Device.NowUs + TimeoutMs * 1000.0)
+  {
+    Device.NowUs += TimeoutMs * 1000;
+    return -1;
+  }
+
+  // the interrupt captures the edge; the waiting task runs a little later
+  *EdgeUs = (uint64_t)Edge + 2;
+  Device.NowUs = (uint64_t)Edge + 20 + Sim_Random(30);
+  return 0;
+}
+
+static void
+Sim_Run(const Sim_Scenario_t *Scenario, uint32_t Trials, Sim_Stats_t *Stats)
+{
+  DS13072_Handler_t Handler = {0};
+  DS13072_Sync_t Sync = {0};
+  DS13072_SyncResult_t Result;
+  uint32_t UnixTime;
+  uint64_t StartUs;
+  double Error;
+  uint32_t i;
+
+  // SQW/OUT at 1 Hz
+  SimChip_Init(&Device.Chip);
+  Device.Chip.Regs[SIMCHIP_CONTROL] = 0x10;
+
+  Handler.PlatformSend = Sim_Send;
+  Handler.PlatformReceive = Sim_Receive;
+  Sync.GetMonotonicUs = Sim_GetMonotonicUs;
+  Sync.DelayUs = Sim_DelayUs;
+  Sync.WaitSqwEdge = (Scenario->Sqw != Sim_Sqw_None) ? Sim_WaitSqwEdge : NULL;
+  Sync.MaxReads = Scenario->MaxReads;
+
+  memset(Stats, 0, sizeof(*Stats));
+  for (i = 0; i < Trials; i++)
+  {
+    Device.Scenario = Scenario;
+    Device.NowUs = 10000000 + Sim_Random(1000);
+    Device.PeriodUs = 1000000.0 / (1.0 + Scenario->DriftPpm * 1e-6);
+    Device.PhaseUs = Device.NowUs + Sim_Random(999999);
+    StartUs = Device.NowUs;
+
+    Stats->Trials++;
+    if (DS13072_SyncToSecondEdge(&Handler, &Sync, &Result) != DS13072_OK)
+      continue;
+
+    Stats->Success++;
+    Stats->ReadsSum += Result.BusReads;
+    if (Result.BusReads > Stats->ReadsMax)
+      Stats->ReadsMax = Result.BusReads;
+    Stats->DurationSum += (double)(Device.NowUs - StartUs);
+    Stats->UncertaintySum += Result.UncertaintyUs;
+
+    if (DS13072_DateTimeToUnix(&Result.DateTime, &UnixTime) != DS13072_OK ||
+        UnixTime <= SIM_BASE_TIME)
+    {
+      Stats->WrongTime++;
+      continue;
+    }
+
+    Error = (double)Result.EdgeUs - Sim_EdgeUs(UnixTime);
+    if (Error < 0)
+      Error = -Error;
+    if (Error > 500000)
+    {
+      Stats->WrongTime++;
+      continue;
+    }
+
+    Stats->ErrorSum += Error;
+    if (Error > Stats->ErrorMax)
+      Stats->ErrorMax = Error;
+    // the SQW path reports 0: its accuracy is that of the edge capture
+    if (Error > Result.UncertaintyUs + (Result.UncertaintyUs ? 1 : 5))
+      Stats->Outside++;
+  }
+}
+
+
+
+/**
+ ==================================================================================
+                                ##### Main #####
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  const Sim_Scenario_t *Scenario;
+  Sim_Stats_t Stats;
+  uint32_t Trials = 1000;
+  uint32_t Success;
+  int Status = 0;
+  size_t i;
+
+  if (argc > 2 || (argc == 2 && (Trials = strtoul(argv[1], NULL, 10)) == 0))
+  {
+    fprintf(stderr, "usage: %s [trials]\n", argv[0]);
+    return 1;
+  }
+
+  printf("%-14s %9s %10s %10s %11s %9s %9s %10s\n", "scenario", "success",
+         "err avg", "err max", "uncert avg", "reads avg", "reads max",
+         "time avg");
+  for (i = 0; i < sizeof(Scenarios) / sizeof(Scenarios[0]); i++)
+  {
+    Scenario = &Scenarios[i];
+    Sim_Run(Scenario, Trials, &Stats);
+    Success = Stats.Success ? Stats.Success : 1;
+
+    printf("%-14s %4u/%-4u %7.0f us %7.0f us %8.0f us %9.1f %9u %7.0f ms\n",
+           Scenario->Name, Stats.Success, Stats.Trials,
+           Stats.ErrorSum / Success, Stats.ErrorMax,
+           Stats.UncertaintySum / Success, (double)Stats.ReadsSum / Success,
+           Stats.ReadsMax, Stats.DurationSum / Success / 1000);
+
+    if (Stats.Outside || Stats.WrongTime)
+    {
+      printf("  %u edges outside the uncertainty, %u wrong date and time\n",
+             Stats.Outside, Stats.WrongTime);
+      Status = 3;
+    }
+    if (Scenario->MustSucceed && Stats.Success != Stats.Trials)
+      Status = 3;
+    if (!Scenario->MustSucceed && Stats.Success)
+      Status = 3;
+  }
+
+  return Status;
+}
@@ -0,0 +1,419 @@
+/**
+ **********************************************************************************
+ * @file   ds13072_sysclocksim.c
+ * @brief  Host tool: run the DS13072 system clock integration against fake
+ *         clocks and a simulated DS1307, and count the RTC writes under
+ *         bursts of time adjustments.
+ *
+ *         Build (from the tools directory):
+ *           make ds13072_sysclocksim
+ *
+ *         Usage:
+ *           ds13072_sysclocksim
+ *
+ *         Time is simulated: the monotonic clock only moves when the tool
+ *         advances it, and the Schedule timer fires when its deadline is
+ *         passed. Exits with 3 if a scenario writes the RTC more often than
+ *         the rate limit allows, loses the last adjustment, or lets the RTC
+ *         drift further than the threshold.
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "DS13072.h"
+#include "DS13072_sysclock.h"
+#include "ds13072_simchip.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define SIM_BASE_TIME       1717243200ULL  // 2024-06-01 12:00:00
+#define SIM_THRESHOLD_MS    2000
+#define SIM_INTERVAL_MS     60000
+#define SIM_HOUR_MS         3600000ULL
+#define SIM_DAY_MS          (24 * SIM_HOUR_MS)
+
+
+/* Private Types ----------------------------------------------------------------*/
+typedef struct Sim_State_s
+{
+  uint64_t  NowMs;           // monotonic clock
+  int64_t   SystemOffsetMs;  // system time minus monotonic time
+  uint8_t   UseSchedule;
+
+  // simulated chip
+  double    DriftPpm;
+  uint64_t  RtcBaseMs;       // monotonic time of the last seconds write
+  uint64_t  RtcBaseUnix;     // RTC time at RtcBaseMs
+  uint8_t   RtcLost;         // registers hold no valid date and time
+  SimChip_t Chip;
+
+  // Schedule timer
+  uint8_t   TimerArmed;
+  uint64_t  TimerDueMs;
+
+  // statistics
+  uint32_t  Updates;
+  uint32_t  Failures;
+  int64_t   MaxErrorMs;      // largest |RTC - system| seen after an update
+} Sim_State_t;
+
+typedef struct Sim_Scenario_s
+{
+  const char  *Name;
+  void        (*Run)(DS13072_SysClock_t *SysClock);
+  uint8_t     UseSchedule;
+  double      DriftPpm;
+  uint8_t     RtcLost;
+  uint32_t    MaxWrites;     // upper bound of WriteCount
+  uint32_t    MinWrites;     // lower bound of WriteCount
+  int64_t     MaxErrorMs;    // bound of |RTC - system| after the last update
+} Sim_Scenario_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static Sim_State_t Sim;
+static uint64_t RandomState = 0x9E3779B97F4A7C15ULL;
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+static uint32_t
+Sim_Random(uint32_t Max)
+{
+  RandomState ^= RandomState << 13;
+  RandomState ^= RandomState >> 7;
+  RandomState ^= RandomState << 17;
+  return Max ? (uint32_t)(RandomState % (Max + 1)) : 0;
+}
+
+/**
+ * @brief  Time held by the chip in ms, with its crystal error
+ */
+static int64_t
+Sim_RtcMs(void)
+{
+  double Elapsed = (double)(Sim.NowMs - Sim.RtcBaseMs) *
+                   (1.0 + Sim.DriftPpm * 1e-6);
+
+  return (int64_t)Sim.RtcBaseUnix * 1000 + (int64_t)Elapsed;
+}
+
+static int64_t
+Sim_SystemMs(void)
+{
+  return (int64_t)Sim.NowMs + Sim.SystemOffsetMs;
+}
+
+static int8_t
+Sim_Send(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  DS13072_DateTime_t DateTime;
+  uint32_t UnixTime;
+
+  if (SimChip_Send(&Sim.Chip, Address, Data, Len) < 0)
+    return -1;
+
+  if (Len == 1)
+    return 0;
+
+  // the driver writes the whole date and time in one transfer
+  if (Data[0] != 0 || Len < 8)
+    return -1;
+
+  if (DS13072_RegsToDateTime(&Data[1], &DateTime) != DS13072_OK ||
+      DS13072_DateTimeToUnix(&DateTime, &UnixTime) != DS13072_OK)
+    return -1;
+
+  // writing the seconds register restarts the sub-second countdown
+  Sim.RtcBaseUnix = UnixTime;
+  Sim.RtcBaseMs = Sim.NowMs;
+  Sim.RtcLost = 0;
+  return 0;
+}
+
+static int8_t
+Sim_Receive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  if (Sim.RtcLost ||
+      SimChip_SetTime(&Sim.Chip, (uint32_t)(Sim_RtcMs() / 1000)) < 0)
+    memset(Sim.Chip.Regs, 0, 7);
+
+  return SimChip_Receive(&Sim.Chip, Address, Data, Len);
+}
+
+static int8_t
+Sim_GetSystemTime(uint64_t *TimeMs)
+{
+  *TimeMs = (uint64_t)Sim_SystemMs();
+  return 0;
+}
+
+static int8_t
+Sim_SetSystemTime(uint64_t TimeMs)
+{
+  Sim.SystemOffsetMs = (int64_t)TimeMs - (int64_t)Sim.NowMs;
+  return 0;
+}
+
+static int8_t
+Sim_GetMonotonicTime(uint64_t *TimeMs)
+{
+  *TimeMs = Sim.NowMs;
+  return 0;
+}
+
+static int8_t
+Sim_Schedule(uint32_t DelayMs)
+{
+  Sim.TimerArmed = 1;
+  Sim.TimerDueMs = Sim.NowMs + DelayMs;
+  return 0;
+}
+
+static void
+Sim_Update(DS13072_SysClock_t *SysClock)
+{
+  int64_t Error;
+
+  Sim.Updates++;
+  if (DS13072_SysClock_Update(SysClock) != DS13072_OK)
+    Sim.Failures++;
+
+  Error = Sim_RtcMs() - Sim_SystemMs();
+  if (Error < 0)
+    Error = -Error;
+  if (!SysClock->Pending && Error > Sim.MaxErrorMs)
+    Sim.MaxErrorMs = Error;
+}
+
+/**
+ * @brief  Let time pass; the Schedule timer fires on the way
+ */
+static void
+Sim_Advance(DS13072_SysClock_t *SysClock, uint64_t Ms)
+{
+  uint64_t End = Sim.NowMs + Ms;
+
+  while (Sim.TimerArmed && Sim.TimerDueMs <= End)
+  {
+    Sim.NowMs = Sim.TimerDueMs;
+    Sim.TimerArmed = 0;
+    Sim_Update(SysClock);
+  }
+
+  Sim.NowMs = End;
+}
+
+/**
+ * @brief  Step the system clock, as settimeofday() or SNTP does, and report
+ *         it like the SNTP sync notification callback
+ */
+static void
+Sim_Adjust(DS13072_SysClock_t *SysClock, int64_t StepMs)
+{
+  Sim.SystemOffsetMs += StepMs;
+  Sim_Update(SysClock);
+}
+
+/**
+ * @brief  SNTP first sync, then 100 corrections within 2 s ending with a
+ *         +100 s step
+ */
+static void
+Sim_RunBurst(DS13072_SysClock_t *SysClock)
+{
+  uint32_t i;
+
+  Sim_Adjust(SysClock, 5000);
+  for (i = 0; i < 99; i++)
+  {
+    Sim_Advance(SysClock, 20);
+    Sim_Adjust(SysClock, (int64_t)Sim_Random(6000) - 3000);
+  }
+  Sim_Advance(SysClock, 20);
+  Sim_Adjust(SysClock, 100000);
+
+  if (SysClock->WriteCount != 1)
+    printf("  %u writes during the burst\n", SysClock->WriteCount);
+
+  // without Schedule the application calls Update every 10 s
+  for (i = 0; i < 60; i++)
+  {
+    Sim_Advance(SysClock, 10000);
+    if (!Sim.UseSchedule)
+      Sim_Update(SysClock);
+  }
+}
+
+/**
+ * @brief  Random steps every 100 ms for 10 minutes
+ */
+static void
+Sim_RunStorm(DS13072_SysClock_t *SysClock)
+{
+  uint32_t i;
+
+  for (i = 0; i < 6000; i++)
+  {
+    Sim_Advance(SysClock, 100);
+    Sim_Adjust(SysClock, (int64_t)Sim_Random(6000) - 3000);
+  }
+  Sim_Advance(SysClock, SIM_INTERVAL_MS);
+}
+
+/**
+ * @brief  System clock kept exact by SNTP, reported every hour for a week
+ */
+static void
+Sim_RunDrift(DS13072_SysClock_t *SysClock)
+{
+  uint32_t i;
+
+  for (i = 0; i < 7 * 24; i++)
+  {
+    Sim_Advance(SysClock, SIM_HOUR_MS);
+    Sim_Adjust(SysClock, 0);
+  }
+}
+
+/**
+ * @brief  A step that is undone before the deadline is not written
+ */
+static void
+Sim_RunUndo(DS13072_SysClock_t *SysClock)
+{
+  Sim_Adjust(SysClock, 5000);
+  Sim_Advance(SysClock, 1000);
+  Sim_Adjust(SysClock, 10000);
+  Sim_Advance(SysClock, 1000);
+  Sim_Adjust(SysClock, -10000);
+  Sim_Advance(SysClock, 2 * SIM_INTERVAL_MS);
+}
+
+/**
+ * @brief  RTC lost its time: SNTP sets the system clock and the first update
+ *         writes it
+ */
+static void
+Sim_RunLost(DS13072_SysClock_t *SysClock)
+{
+  Sim.SystemOffsetMs = (int64_t)SIM_BASE_TIME * 1000 - (int64_t)Sim.NowMs;
+  Sim_Adjust(SysClock, 0);
+  Sim_Advance(SysClock, SIM_INTERVAL_MS);
+}
+
+static const Sim_Scenario_t Scenarios[] =
+{
+  {"burst",          Sim_RunBurst, 1,   0.0, 0,  2,  2, 1000},
+  {"burst-polled",   Sim_RunBurst, 0,   0.0, 0,  2,  2, 1000},
+  {"storm",          Sim_RunStorm, 1,   0.0, 0, 11, 10, 1000},
+  {"drift+20ppm",    Sim_RunDrift, 1,  20.0, 0,  7,  4, SIM_THRESHOLD_MS + 1000},
+  {"drift-20ppm",    Sim_RunDrift, 1, -20.0, 0,  7,  4, SIM_THRESHOLD_MS + 1000},
+  {"undo",           Sim_RunUndo,  1,   0.0, 0,  1,  1, 1000},
+  {"lost",           Sim_RunLost,  1,   0.0, 1,  1,  1, 1000},
+};
+
+static int
+Sim_Run(const Sim_Scenario_t *Scenario)
+{
+  DS13072_Handler_t Handler = {0};
+  DS13072_SysClock_t SysClock = {0};
+  int64_t FinalError;
+  int Status = 0;
+
+  memset(&Sim, 0, sizeof(Sim));
+  SimChip_Init(&Sim.Chip);
+  Sim.NowMs = 1000000;
+  Sim.UseSchedule = Scenario->UseSchedule;
+  Sim.DriftPpm = Scenario->DriftPpm;
+  Sim.RtcLost = Scenario->RtcLost;
+  Sim.RtcBaseUnix = SIM_BASE_TIME;
+  Sim.RtcBaseMs = Sim.NowMs - Sim_Random(999);
+
+  Handler.PlatformSend = Sim_Send;
+  Handler.PlatformReceive = Sim_Receive;
+  SysClock.Handler = &Handler;
+  SysClock.GetSystemTime = Sim_GetSystemTime;
+  SysClock.SetSystemTime = Sim_SetSystemTime;
+  SysClock.GetMonotonicTime = Sim_GetMonotonicTime;
+  SysClock.Schedule = Scenario->UseSchedule ? Sim_Schedule : NULL;
+  SysClock.ThresholdMs = SIM_THRESHOLD_MS;
+  SysClock.MinIntervalMs = SIM_INTERVAL_MS;
+
+  if (DS13072_Init(&Handler) != DS13072_OK ||
+      DS13072_SysClock_Init(&SysClock) != DS13072_OK)
+  {
+    printf("%-14s init failed\n", Scenario->Name);
+    return 3;
+  }
+
+  Scenario->Run(&SysClock);
+
+  FinalError = Sim_RtcMs() - Sim_SystemMs();
+  if (FinalError < 0)
+    FinalError = -FinalError;
+
+  printf("%-14s %7u %7u %7u %9u %9.3f s %9.3f s\n", Scenario->Name,
+         Sim.Updates, SysClock.WriteCount, Sim.Chip.Writes, Sim.Chip.Reads,
+         Sim.MaxErrorMs / 1000.0, FinalError / 1000.0);
+
+  if (SysClock.WriteCount != Sim.Chip.Writes ||
+      SysClock.WriteCount > Scenario->MaxWrites ||
+      SysClock.WriteCount < Scenario->MinWrites)
+  {
+    printf("  expected %u to %u writes\n",
+           Scenario->MinWrites, Scenario->MaxWrites);
+    Status = 3;
+  }
+  if (FinalError > Scenario->MaxErrorMs ||
+      Sim.MaxErrorMs > SIM_THRESHOLD_MS + 1000)
+  {
+    printf("  RTC is too far from the system clock\n");
+    Status = 3;
+  }
+  if (Sim.Failures || SysClock.Pending)
+  {
+    printf("  %u failed updates, pending %u\n", Sim.Failures, SysClock.Pending);
+    Status = 3;
+  }
+
+  return Status;
+}
+
+
+
+/**
+ ==================================================================================
+                                ##### Main #####
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  int Status = 0;
+  size_t i;
+
+  if (argc != 1)
+  {
+    fprintf(stderr, "usage: %s\n", argv[0]);
+    return 1;
+  }
+
+  printf("%-14s %7s %7s %7s %9s %11s %11s\n", "scenario", "updates",
+         "writes", "bus wr", "bus reads", "max error", "final error");
+  for (i = 0; i < sizeof(Scenarios) / sizeof(Scenarios[0]); i++)
+  {
+    if (Sim_Run(&Scenarios[i]) != 0)
+      Status = 3;
+  }
+
+  return Status;
+}
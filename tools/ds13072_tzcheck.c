@@ -0,0 +1,291 @@
+/**
+ **********************************************************************************
+ * @file   ds13072_tzcheck.c
+ * @brief  Host tool: check the DS13072 time zone conversions against the C
+ *         library's localtime_r() and time both.
+ *
+ *         Build (from the tools directory):
+ *           make ds13072_tzcheck
+ *
+ *         Usage:
+ *           ds13072_tzcheck [step seconds]
+ *
+ *         For every predefined zone the POSIX TZ string is compiled with
+ *         DS13072_TZ_Parse and must give the predefined zone. Then every
+ *         UTC time from 2000 to 2099, 30 minutes apart by default, is
+ *         converted with DS13072_TZ_UtcToLocal and with localtime_r() under
+ *         the same TZ string; local time and DST flag must agree. The local
+ *         time must convert back with DS13072_TZ_LocalToUtc (to the daylight
+ *         time when it occurs twice). Malformed TZ strings must be rejected.
+ *         Exits with 3 on a mismatch.
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "DS13072.h"
+#include "DS13072_tz.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define SIM_STEP          1800  // default step between checked times
+#define SIM_BENCH_STEP    61001 // step of the timed conversions, ~17 h
+#define SIM_MAX_REPORTS   5     // mismatches printed per zone
+
+
+/* Private Types ----------------------------------------------------------------*/
+typedef struct Sim_Zone_s
+{
+  const char          *Posix;
+  const DS13072_TZ_t  *Zone;
+} Sim_Zone_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static const Sim_Zone_t Zones[] =
+{
+  {"UTC0",                          &DS13072_TZ_UTC},
+  {"CET-1CEST,M3.5.0,M10.5.0/3",    &DS13072_TZ_CentralEurope},
+  {"GMT0BST,M3.5.0/1,M10.5.0",      &DS13072_TZ_UK},
+  {"EST5EDT,M3.2.0,M11.1.0",        &DS13072_TZ_USEastern},
+  {"PST8PDT,M3.2.0,M11.1.0",        &DS13072_TZ_USPacific},
+  {"IST-5:30",                      &DS13072_TZ_India},
+  {"AEST-10AEDT,M10.1.0,M4.1.0/3",  &DS13072_TZ_AUEastern},
+};
+
+static const char *const Malformed[] =
+{
+  "CET-1CEST,M268.1.0,M10.5.0/3",   // month wraps in a uint8_t
+  "CET-1CEST,M3.5.0,M10.5.256",     // weekday wraps to 0
+  "CET-1CEST,M3.261.0,M10.5.0/3",   // week wraps to 5
+  "CET-1CEST,M13.5.0,M10.5.0/3",
+  "CET-1CEST,M3.0.0,M10.5.0/3",
+  "CET-1CEST,M3.5.7,M10.5.0/3",
+  "CET-1CEST,M3.5.0,M10.5.0/4294967298",
+  "CET-4294967297",
+  "CET-1:60",
+  "CET-1CEST,J60,M10.5.0/3",
+  "CET-1CEST,M3.5.0",
+  "CET-1CEST,M3.5.0,M10.5.0/3,",
+  "CE-1",
+  "<CET-1",
+  "",
+};
+
+static uint32_t Sink;
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####
+ ==================================================================================
+ */
+
+static uint64_t
+Sim_NowNs(void)
+{
+  struct timespec Ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+  return (uint64_t)Ts.tv_sec * 1000000000ULL + Ts.tv_nsec;
+}
+
+static int
+Sim_SameRule(const DS13072_TZRule_t *a, const DS13072_TZRule_t *b)
+{
+  return a->Month == b->Month && a->Week == b->Week &&
+         a->WeekDay == b->WeekDay && a->Time == b->Time;
+}
+
+static int
+Sim_SameZone(const DS13072_TZ_t *a, const DS13072_TZ_t *b)
+{
+  if (strcmp(a->StdName, b->StdName) != 0 ||
+      a->StdOffset != b->StdOffset || a->HasDst != b->HasDst)
+    return 0;
+
+  if (!a->HasDst)
+    return 1;
+
+  return strcmp(a->DstName, b->DstName) == 0 &&
+         a->DstOffset == b->DstOffset &&
+         Sim_SameRule(&a->Start, &b->Start) && Sim_SameRule(&a->End, &b->End);
+}
+
+static uint32_t
+Sim_CheckParser(void)
+{
+  DS13072_TZ_t Zone;
+  uint32_t Errors = 0;
+  size_t i;
+
+  for (i = 0; i < sizeof(Zones) / sizeof(Zones[0]); i++)
+  {
+    if (DS13072_TZ_Parse(Zones[i].Posix, &Zone) != DS13072_OK ||
+        !Sim_SameZone(&Zone, Zones[i].Zone))
+    {
+      printf("\"%s\" does not compile to the predefined zone\n",
+             Zones[i].Posix);
+      Errors++;
+    }
+  }
+
+  for (i = 0; i < sizeof(Malformed) / sizeof(Malformed[0]); i++)
+  {
+    if (DS13072_TZ_Parse(Malformed[i], &Zone) == DS13072_OK)
+    {
+      printf("\"%s\" is accepted\n", Malformed[i]);
+      Errors++;
+    }
+  }
+
+  printf("%-30s %zu valid, %zu malformed strings, %s\n", "DS13072_TZ_Parse",
+         sizeof(Zones) / sizeof(Zones[0]),
+         sizeof(Malformed) / sizeof(Malformed[0]), Errors ? "FAILED" : "ok");
+  return Errors;
+}
+
+/**
+ * @brief  Compare one zone with localtime_r() over 2000 to 2099
+ */
+static uint32_t
+Sim_CheckZone(const Sim_Zone_t *Sim, uint32_t Step)
+{
+  DS13072_TZCache_t Cache = {0};
+  DS13072_TZCache_t BackCache = {0};
+  struct tm Tm;
+  time_t Time;
+  uint32_t Utc;
+  uint32_t Local;
+  uint32_t Back;
+  uint32_t BackLocal;
+  uint32_t Checked = 0;
+  uint32_t Transitions = 0;
+  uint32_t Errors = 0;
+  uint8_t IsDst;
+  uint8_t BackDst;
+  uint8_t LastDst = 0xFF;
+
+  setenv("TZ", Sim->Posix, 1);
+  tzset();
+
+  for (Utc = DS13072_UNIX_2000; Utc < DS13072_UNIX_2100; Utc += Step)
+  {
+    Time = Utc;
+    localtime_r(&Time, &Tm);
+
+    if (DS13072_TZ_UtcToLocal(Sim->Zone, &Cache, Utc,
+                              &Local, &IsDst) != DS13072_OK ||
+        Local != Utc + (uint32_t)Tm.tm_gmtoff || IsDst != (Tm.tm_isdst > 0))
+    {
+      if (Errors < SIM_MAX_REPORTS)
+        printf("%s: UTC %u gives %u dst %u, localtime_r %u dst %d\n",
+               Sim->Posix, Utc, Local, IsDst,
+               Utc + (uint32_t)Tm.tm_gmtoff, Tm.tm_isdst);
+      Errors++;
+      continue;
+    }
+
+    // back to UTC: the same time, or the daylight one of a repeated hour
+    if (DS13072_TZ_LocalToUtc(Sim->Zone, &BackCache, Local,
+                              &Back) != DS13072_OK ||
+        (Back != Utc &&
+         (DS13072_TZ_UtcToLocal(Sim->Zone, &BackCache, Back,
+                                &BackLocal, &BackDst) != DS13072_OK ||
+          BackLocal != Local || !BackDst)))
+    {
+      if (Errors < SIM_MAX_REPORTS)
+        printf("%s: local %u of UTC %u goes back to %u\n",
+               Sim->Posix, Local, Utc, Back);
+      Errors++;
+    }
+
+    if (LastDst != 0xFF && IsDst != LastDst)
+      Transitions++;
+    LastDst = IsDst;
+    Checked++;
+  }
+
+  printf("%-30s %u times, %u transitions, %s\n", Sim->Posix, Checked,
+         Transitions, Errors ? "FAILED" : "ok");
+  return Errors;
+}
+
+static void
+Sim_Benchmark(const Sim_Zone_t *Sim)
+{
+  DS13072_TZCache_t Cache = {0};
+  DS13072_DateTime_t DateTime;
+  struct tm Tm;
+  time_t Time;
+  uint32_t Utc;
+  uint32_t Local;
+  uint32_t Count;
+  uint64_t Start;
+  double Library;
+  double Zone;
+
+  setenv("TZ", Sim->Posix, 1);
+  tzset();
+
+  Count = 0;
+  Start = Sim_NowNs();
+  for (Utc = DS13072_UNIX_2000; Utc < DS13072_UNIX_2100;
+       Utc += SIM_BENCH_STEP, Count++)
+  {
+    Time = Utc;
+    localtime_r(&Time, &Tm);
+    Sink += Tm.tm_hour;
+  }
+  Library = (double)(Sim_NowNs() - Start) / Count;
+
+  Count = 0;
+  Start = Sim_NowNs();
+  for (Utc = DS13072_UNIX_2000; Utc < DS13072_UNIX_2100;
+       Utc += SIM_BENCH_STEP, Count++)
+  {
+    DS13072_TZ_UtcToLocal(Sim->Zone, &Cache, Utc, &Local, NULL);
+    DS13072_UnixToDateTime(Local, &DateTime);
+    Sink += DateTime.Hour;
+  }
+  Zone = (double)(Sim_NowNs() - Start) / Count;
+
+  printf("%-30s localtime_r %6.1f ns, DS13072_TZ %6.1f ns\n",
+         Sim->Posix, Library, Zone);
+}
+
+
+
+/**
+ ==================================================================================
+                                ##### Main #####
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  uint32_t Step = SIM_STEP;
+  uint32_t Errors;
+  size_t i;
+
+  if (argc > 2 || (argc == 2 && (Step = strtoul(argv[1], NULL, 0)) == 0))
+  {
+    fprintf(stderr, "usage: %s [step seconds]\n", argv[0]);
+    return 1;
+  }
+
+  Errors = Sim_CheckParser();
+  for (i = 0; i < sizeof(Zones) / sizeof(Zones[0]); i++)
+    Errors += Sim_CheckZone(&Zones[i], Step);
+
+  printf("\nconversion to local date and time, 2000 to 2099:\n");
+  for (i = 0; i < sizeof(Zones) / sizeof(Zones[0]); i++)
+    Sim_Benchmark(&Zones[i]);
+
+  return Errors ? 3 : (Sink == 0xFFFFFFFF ? 2 : 0);
+}
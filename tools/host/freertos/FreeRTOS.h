@@ -0,0 +1,48 @@
+/**
+ **********************************************************************************
+ * @file   FreeRTOS.h
+ * @brief  Host shim of the FreeRTOS types used by the DS13072 modules, for the
+ *         host tools. Tasks are POSIX threads; the functions are implemented
+ *         by the tool that includes this header.
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include <pthread.h>
+
+
+/* Exported Constants -----------------------------------------------------------*/
+#ifndef configTICK_RATE_HZ
+#define configTICK_RATE_HZ  1000
+#endif
+
+#define portTICK_PERIOD_MS  (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY       0xFFFFFFFFUL
+#define pdMS_TO_TICKS(ms)   ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              1
+#define pdFAIL              0
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+/**
+ * @brief  Critical sections are a mutex
+ */
+typedef pthread_mutex_t portMUX_TYPE;
+
+#define portMUX_INITIALIZE(Mux)    pthread_mutex_init((Mux), NULL)
+#define taskENTER_CRITICAL(Mux)    pthread_mutex_lock(Mux)
+#define taskEXIT_CRITICAL(Mux)     pthread_mutex_unlock(Mux)
+
+
+#endif //! INC_FREERTOS_H
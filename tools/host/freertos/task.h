@@ -0,0 +1,53 @@
+/**
+ **********************************************************************************
+ * @file   task.h
+ * @brief  Host shim of the FreeRTOS task functions used by the DS13072
+ *         modules, for the host tools.
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#ifndef INC_FREERTOS_H
+#error "include FreeRTOS.h must appear in source files before include task.h"
+#endif
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *Param);
+
+
+/**
+ ==================================================================================
+                             ##### Functions #####
+ ==================================================================================
+ */
+
+BaseType_t
+xTaskCreate(TaskFunction_t Function, const char *Name, uint32_t StackSize,
+            void *Param, UBaseType_t Priority, TaskHandle_t *Handle);
+
+void
+vTaskDelete(TaskHandle_t Task);
+
+void
+vTaskDelay(TickType_t Ticks);
+
+void
+vTaskDelayUntil(TickType_t *PreviousWakeTime, TickType_t TimeIncrement);
+
+TickType_t
+xTaskGetTickCount(void);
+
+BaseType_t
+xTaskNotifyGiveIndexed(TaskHandle_t Task, UBaseType_t Index);
+
+uint32_t
+ulTaskNotifyTakeIndexed(UBaseType_t Index, BaseType_t ClearOnExit,
+                        TickType_t Ticks);
+
+
+#endif //! INC_TASK_H